@@ -0,0 +1,310 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/range/adaptors.hpp>
+#include <boost/range/algorithm.hpp>
+#include <boost/range/numeric.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "game.hpp"
+
+namespace liars_dice {
+  // 他のプレイヤーのダイスの目の推定。席毎に、手（hand_index()の番号）の事後確率を持っておいて、宣言を見る度にベイズ更新します。
+  // 宣言の尤度は、差し替え可能な宣言者のモデルで計算します。更新は新しい宣言の分だけなので、action()の度に最初から計算し直す必要はありません。
+
+  // dice_count個のダイスの手の表。手の番号毎の、事前確率と、目毎のダイスの数（1の目も含めた数。目1は1の目の数）を持ちます。
+  class hand_table final {
+    int _dice_count;
+    std::vector<float> _prior_probabilities;
+    std::array<std::vector<float>, 7> _face_counts;
+
+  public:
+    hand_table(int dice_count) noexcept: _dice_count(dice_count), _prior_probabilities(hand_count(dice_count)), _face_counts() {
+      for (auto& face_counts: _face_counts) {
+        face_counts = std::vector<float>(hand_count(dice_count));
+      }
+
+      for (auto i = 0; i < hand_count(dice_count); ++i) {
+        const auto& faces = index_hand(dice_count, i);
+
+        // 多項分布の確率。dice_count! / (目毎の数!の積) / 6^dice_count。
+        auto prior_probability = 1.0f;
+
+        for (auto j = 0, k = 0; j < dice_count; ++j) {
+          k = j > 0 && faces[j] == faces[j - 1] ? k + 1 : 1;
+
+          prior_probability *= static_cast<float>(j + 1) / k / 6;
+        }
+
+        _prior_probabilities[i] = prior_probability;
+
+        for (auto face = 1; face <= 6; ++face) {
+          _face_counts[face][i] = static_cast<float>(std::count_if(std::begin(faces), std::end(faces), [&](const auto& face_) { return face_ == 1 || face_ == face; }));
+        }
+      }
+    }
+
+    const auto& dice_count() const noexcept {
+      return _dice_count;
+    }
+
+    auto size() const noexcept {
+      return static_cast<int>(std::size(_prior_probabilities));
+    }
+
+    const auto& prior_probabilities() const noexcept {
+      return _prior_probabilities;
+    }
+
+    const auto& face_counts(int face) const noexcept {
+      return _face_counts[face];
+    }
+  };
+
+  // 宣言者のモデル。
+  class bidder_model {
+  public:
+    virtual ~bidder_model() {
+      ;
+    }
+
+    // hand_tableの全ての手について、previous_bidの後にbidを宣言する尤度をlikelihoodsに書き込みます。尤度は、手の間の比だけが意味を持ちます。
+    virtual void likelihoods(const hand_table& hand_table, const std::optional<bid>& previous_bid, const bid& bid, std::vector<float>& likelihoods) const noexcept = 0;
+  };
+
+  // 宣言から何も読み取らないモデル。事後確率は事前確率のままになります。
+  class uniform_bidder_model final: public bidder_model {
+  public:
+    void likelihoods(const hand_table& hand_table, const std::optional<bid>& previous_bid, const bid& bid, std::vector<float>& likelihoods) const noexcept override {
+      std::fill(std::begin(likelihoods), std::begin(likelihoods) + hand_table.size(), 1.0f);
+    }
+  };
+
+  // 持っている目（1の目を含む）ほど宣言しやすいというモデル。目の選び方を、目毎のダイスの数のソフトマックスとし、bluff_rateの割合でランダムに選ぶ（ブラフ）とします。
+  class face_preference_bidder_model final: public bidder_model {
+    float _inverse_temperature;
+    float _bluff_rate;
+
+  public:
+    face_preference_bidder_model(float inverse_temperature, float bluff_rate) noexcept: _inverse_temperature(inverse_temperature), _bluff_rate(bluff_rate) {
+      ;
+    }
+
+    face_preference_bidder_model() noexcept: face_preference_bidder_model(1.0f, 0.3f) {
+      ;
+    }
+
+    void likelihoods(const hand_table& hand_table, const std::optional<bid>& previous_bid, const bid& bid, std::vector<float>& likelihoods) const noexcept override {
+      const auto& size = hand_table.size();
+
+      // ループを目毎に分けて、コンパイラーがベクトル化できるようにします。
+      auto denominators = std::vector<float>(size, 0.0f);
+
+      for (auto face = 2; face <= 6; ++face) {
+        const auto& face_counts = hand_table.face_counts(face);
+
+        for (auto i = 0; i < size; ++i) {
+          denominators[i] += std::exp(_inverse_temperature * face_counts[i]);
+        }
+      }
+
+      const auto& face_counts = hand_table.face_counts(bid.face());
+
+      for (auto i = 0; i < size; ++i) {
+        likelihoods[i] = (1.0f - _bluff_rate) * std::exp(_inverse_temperature * face_counts[i]) / denominators[i] + _bluff_rate / 5;
+      }
+    }
+  };
+
+  class belief_tracker final {
+    std::shared_ptr<const bidder_model> _bidder_model;
+    int _player_index;
+    std::vector<int> _faces;
+    std::vector<int> _dice_counts;
+    std::vector<hand_table> _hand_tables;            // [ダイスの数]
+    std::vector<std::vector<float>> _probabilities;  // [席][手の番号]。自分の席は空です。
+    std::vector<float> _likelihoods;
+    int _action_count;                               // 更新に使用した手の数。
+    std::vector<int> _action_indices;                // 更新に使用した手（宣言の番号。チャレンジは0）。同じゲームの続きかを判定するために使用します。
+
+    auto action_count(const game& game) const noexcept {
+      return boost::accumulate(game.players() | boost::adaptors::transformed([](const auto& player) { return static_cast<int>(std::size(player.actions())); }), 0);
+    }
+
+    // 全体でindex番目の手の、宣言の番号。チャレンジは0です。
+    static auto action_index(const game& game, int index) noexcept {
+      const auto& action = game.players()[index % std::size(game.players())].actions()[index / std::size(game.players())];
+
+      return action.bid() ? bid_index(action.bid().value()) : 0;
+    }
+
+    // 席と手とダイスの数が同じでも、前のゲームが自分の2回目の手番の前に終わった別のゲームかもしれないので、更新に使用した手が同じかも確認します。
+    auto is_same_game(const game& game) const noexcept {
+      if (game.player_index() != _player_index || game.players()[game.player_index()].faces() != _faces || action_count(game) < _action_count) {
+        return false;
+      }
+
+      if (!boost::equal(game.players() | boost::adaptors::transformed([](const auto& player) { return static_cast<int>(std::size(player.faces())); }), _dice_counts)) {
+        return false;
+      }
+
+      for (auto i = 0; i < _action_count; ++i) {
+        if (action_index(game, i) != _action_indices[i]) {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+  public:
+    belief_tracker(std::shared_ptr<const bidder_model> bidder_model) noexcept: _bidder_model(bidder_model), _player_index(-1), _faces(), _dice_counts(), _hand_tables(), _probabilities(), _likelihoods(), _action_count(0), _action_indices() {
+      ;
+    }
+
+    belief_tracker() noexcept: belief_tracker(std::make_shared<face_preference_bidder_model>()) {
+      ;
+    }
+
+    // gameの手番のプレイヤーから見た推定を、事前確率に戻します。
+    auto reset(const game& game) noexcept {
+      _player_index = game.player_index();
+      _faces        = game.players()[game.player_index()].faces();
+      _dice_counts  = boost::copy_range<std::vector<int>>(game.players() | boost::adaptors::transformed([](const auto& player) { return static_cast<int>(std::size(player.faces())); }));
+
+      for (auto dice_count = static_cast<int>(std::size(_hand_tables)); dice_count <= *std::max_element(std::begin(_dice_counts), std::end(_dice_counts)); ++dice_count) {
+        _hand_tables.emplace_back(dice_count);
+      }
+
+      _probabilities = std::vector<std::vector<float>>(std::size(_dice_counts));
+
+      for (auto i = 0; i < static_cast<int>(std::size(_dice_counts)); ++i) {
+        if (i != _player_index) {
+          _probabilities[i] = _hand_tables[_dice_counts[i]].prior_probabilities();
+        }
+      }
+
+      _likelihoods  = std::vector<float>(std::size(_hand_tables.back().prior_probabilities()));
+      _action_count = 0;
+
+      _action_indices.clear();
+    }
+
+    // gameの、前回の更新以降の宣言で推定を更新します。別のゲームなら、事前確率に戻してから更新します。gameの最初のプレイヤーが、最初に宣言したプレイヤーでなければなりません。
+    auto update(const game& game) noexcept {
+      if (!is_same_game(game)) {
+        reset(game);
+      }
+
+      const auto& player_count = static_cast<int>(std::size(game.players()));
+
+      for (const auto& count = action_count(game); _action_count < count; ++_action_count) {
+        const auto& player_index = _action_count % player_count;
+        const auto& action       = game.players()[player_index].actions()[_action_count / player_count];
+
+        _action_indices.emplace_back(action_index(game, _action_count));
+
+        if (!action.bid() || player_index == _player_index) {
+          continue;
+        }
+
+        const auto& previous_bid = [&]() -> std::optional<bid> {
+          if (_action_count == 0) {
+            return std::nullopt;
+          }
+
+          return game.players()[(_action_count - 1) % player_count].actions()[(_action_count - 1) / player_count].bid();
+        }();
+
+        const auto& hand_table = _hand_tables[_dice_counts[player_index]];
+
+        _bidder_model->likelihoods(hand_table, previous_bid, action.bid().value(), _likelihoods);
+
+        auto& probabilities = _probabilities[player_index];
+
+        auto total_probability = 0.0f;
+
+        for (auto i = 0; i < hand_table.size(); ++i) {
+          probabilities[i] *= _likelihoods[i];
+          total_probability += probabilities[i];
+        }
+
+        // 尤度が全て0になるような宣言なら、モデルが外れているので、事前確率に戻します。
+        if (!(total_probability > 0.0f)) {
+          probabilities = hand_table.prior_probabilities();
+
+          continue;
+        }
+
+        for (auto i = 0; i < hand_table.size(); ++i) {
+          probabilities[i] /= total_probability;
+        }
+      }
+    }
+
+    // player_indexの席の、手毎の事後確率。
+    const auto& probabilities(int player_index) const noexcept {
+      return _probabilities[player_index];
+    }
+
+    // 全員のダイスの中の、face（1の目を含む）の数の確率分布。自分のダイスは見えているので確定で、他の席の分布を畳み込みます。
+    auto face_count_probabilities(int face) const noexcept {
+      auto result = std::vector<double>(1, 1.0);
+
+      for (auto i = 0; i < static_cast<int>(std::size(_dice_counts)); ++i) {
+        if (i == _player_index) {
+          continue;
+        }
+
+        const auto& hand_table  = _hand_tables[_dice_counts[i]];
+        const auto& face_counts = hand_table.face_counts(face);
+
+        auto probabilities = std::vector<double>(_dice_counts[i] + 1, 0.0);
+
+        for (auto j = 0; j < hand_table.size(); ++j) {
+          probabilities[static_cast<int>(face_counts[j])] += _probabilities[i][j];
+        }
+
+        auto convolution = std::vector<double>(std::size(result) + _dice_counts[i], 0.0);
+
+        for (auto j = 0; j < static_cast<int>(std::size(result)); ++j) {
+          for (auto k = 0; k <= _dice_counts[i]; ++k) {
+            convolution[j + k] += result[j] * probabilities[k];
+          }
+        }
+
+        result = convolution;
+      }
+
+      const auto& own_count = static_cast<int>(std::count_if(std::begin(_faces), std::end(_faces), [&](const auto& face_) { return face_ == 1 || face_ == face; }));
+
+      result.insert(std::begin(result), own_count, 0.0);
+
+      return result;
+    }
+
+    // bidが正しい（チャレンジされても宣言者が負けない）確率。
+    auto probability(const bid& bid) const noexcept {
+      const auto& face_count_probabilities = belief_tracker::face_count_probabilities(bid.face());
+
+      auto result = 0.0;
+
+      for (auto i = std::max(bid.min_count(), 0); i < static_cast<int>(std::size(face_count_probabilities)); ++i) {
+        result += face_count_probabilities[i];
+      }
+
+      return result;
+    }
+  };
+}
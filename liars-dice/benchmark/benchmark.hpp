@@ -0,0 +1,100 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+namespace liars_dice {
+  // 最適化で計算が消されてしまわないようにするための関数。
+  template <typename T>
+  inline auto do_not_optimize(const T& value) noexcept {
+    #ifdef _MSC_VER
+    static volatile const void* sink; sink = &value;
+    #else
+    asm volatile("" : : "g"(&value) : "memory");
+    #endif
+  }
+
+  struct benchmark_result final {
+    std::string name;
+    std::int64_t iteration_count;          // 1サンプルあたりの繰り返し回数。
+    double median_nanoseconds_per_iteration;
+    double min_nanoseconds_per_iteration;
+    double max_nanoseconds_per_iteration;
+  };
+
+  // functionを、1サンプルが10msec以上になる回数だけ繰り返す計測を、sample_count回実行します。
+  template <typename Function>
+  inline auto run_benchmark(const std::string& name, Function&& function, int sample_count = 15) {
+    const auto& measure = [&](std::int64_t iteration_count) {
+      const auto& starting_time = std::chrono::steady_clock::now();
+
+      for (auto i = static_cast<std::int64_t>(0); i < iteration_count; ++i) {
+        function();
+      }
+
+      return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - starting_time).count();
+    };
+
+    const auto& iteration_count = [&]() {
+      auto result = static_cast<std::int64_t>(1);
+
+      while (measure(result) < 10'000'000 && result < (static_cast<std::int64_t>(1) << 40)) {
+        result *= 2;
+      }
+
+      return result;
+    }();
+
+    auto nanoseconds_per_iterations = std::vector<double>(); nanoseconds_per_iterations.reserve(sample_count);
+
+    for (auto i = 0; i < sample_count; ++i) {
+      nanoseconds_per_iterations.emplace_back(measure(iteration_count) / iteration_count);
+    }
+
+    std::sort(std::begin(nanoseconds_per_iterations), std::end(nanoseconds_per_iterations));
+
+    const auto& result = benchmark_result{name, iteration_count, nanoseconds_per_iterations[sample_count / 2], nanoseconds_per_iterations.front(), nanoseconds_per_iterations.back()};
+
+    std::cerr << std::left << std::setw(48) << result.name << std::right << std::fixed << std::setprecision(1) << std::setw(14) << result.median_nanoseconds_per_iteration << " ns" << std::defaultfloat << std::endl;
+
+    return result;
+  }
+
+  // object -> json
+
+  inline auto write_benchmark_result(const benchmark_result& benchmark_result, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartObject();
+    writer.Key("name");
+    writer.String(benchmark_result.name.c_str());
+    writer.Key("iteration_count");
+    writer.Int64(benchmark_result.iteration_count);
+    writer.Key("median_nanoseconds_per_iteration");
+    writer.Double(benchmark_result.median_nanoseconds_per_iteration);
+    writer.Key("min_nanoseconds_per_iteration");
+    writer.Double(benchmark_result.min_nanoseconds_per_iteration);
+    writer.Key("max_nanoseconds_per_iteration");
+    writer.Double(benchmark_result.max_nanoseconds_per_iteration);
+    writer.EndObject();
+  }
+
+  inline auto write_benchmark_results(const std::vector<benchmark_result>& benchmark_results, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartArray();
+    for (const auto& benchmark_result: benchmark_results) {
+      write_benchmark_result(benchmark_result, writer);
+    }
+    writer.EndArray();
+  }
+}
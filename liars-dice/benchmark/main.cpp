@@ -0,0 +1,181 @@
+﻿#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../belief.hpp"
+#include "../classifier.hpp"
+#include "../game.hpp"
+#include "../json.hpp"
+#include "../transposition_table.hpp"
+#include "../../fool/fool.hpp"
+#include "../../hardhead/hardhead.hpp"
+#include "../../optimist/optimist.hpp"
+#include "../../pessimist/pessimist.hpp"
+#include "../../timid/timid.hpp"
+#include "benchmark.hpp"
+
+// 計測に使用する、6人で5個ずつのダイスのゲーム。毎回同じ内容になるように、固定の値で作成します。
+inline auto sample_game(bool is_end) noexcept {
+  auto result = liars_dice::game({
+    liars_dice::player("A", {1, 2, 3, 3, 5}),
+    liars_dice::player("B", {2, 4, 4, 6, 6}),
+    liars_dice::player("C", {1, 1, 3, 5, 6}),
+    liars_dice::player("D", {2, 2, 3, 4, 5}),
+    liars_dice::player("E", {3, 4, 5, 6, 6}),
+    liars_dice::player("F", {1, 2, 4, 5, 5})});
+
+  for (const auto& [face, min_count]: std::vector<std::tuple<int, int>>{{3, 2}, {3, 3}, {4, 3}, {4, 4}, {6, 4}, {2, 5}, {5, 5}, {5, 6}, {6, 6}, {3, 7}}) {
+    result.do_action(liars_dice::bid(face, min_count));
+  }
+
+  if (is_end) {
+    result.do_action(liars_dice::challenge());
+  }
+
+  return result;
+}
+
+// 計測に使用する、6プログラム分で100試合ずつの戦歴。
+inline auto sample_careers() noexcept {
+  auto result = std::vector<liars_dice::career>();
+
+  for (const auto& id: {"A", "B", "C", "D", "E", "F"}) {
+    result.emplace_back(liars_dice::career{id, std::vector<liars_dice::career_record>(100, liars_dice::career_record{id, sample_game(true)})});
+  }
+
+  return result;
+}
+
+// 計測に使用する、doc/check-other-programs.mdと同じ形（100-1024-512-256-128-64-5）のニューラル・ネットワーク。重みは固定の種の乱数です。
+inline auto sample_classifier() {
+  auto random_engine = std::mt19937_64(0);
+
+  auto layers = std::vector<liars_dice::dense_layer>();
+
+  for (const auto& [input_size, output_size]: std::vector<std::tuple<int, int>>{{100, 1024}, {1024, 512}, {512, 256}, {256, 128}, {128, 64}, {64, 5}}) {
+    auto distribution = std::normal_distribution<float>(0.0f, std::sqrt(2.0f / input_size));
+
+    auto weights = std::vector<float>(input_size * output_size);
+
+    for (auto& weight: weights) {
+      weight = distribution(random_engine);
+    }
+
+    layers.emplace_back(input_size, output_size, weights, std::vector<float>(output_size, 0.0f));
+  }
+
+  return liars_dice::classifier(layers);
+}
+
+int main(int argc, char** argv) {
+  if (argc > 2) {
+    std::cerr << "usage: liars-dice-benchmark [result-path]" << std::endl;
+    std::exit(1);
+  }
+
+  const auto& game       = sample_game(false);
+  const auto& ended_game = sample_game(true);
+  const auto& careers    = sample_careers();
+
+  const auto& game_json    = liars_dice::write_json(game, std::function(liars_dice::write_game));
+  const auto& careers_json = liars_dice::write_json(careers, std::function(liars_dice::write_careers));
+
+  auto results = std::vector<liars_dice::benchmark_result>();
+
+  // game.hpp
+
+  results.emplace_back(liars_dice::run_benchmark("game::face_count", [&]() { liars_dice::do_not_optimize(game.face_count(4)); }));
+  results.emplace_back(liars_dice::run_benchmark("game::is_legal_action", [&]() { liars_dice::do_not_optimize(game.is_legal_action(liars_dice::bid(4, 7))); }));
+  results.emplace_back(liars_dice::run_benchmark("game copy", [&]() { auto game_ = game; liars_dice::do_not_optimize(game_); }));
+  results.emplace_back(liars_dice::run_benchmark("game copy + game::do_action", [&]() { auto game_ = game; game_.do_action(liars_dice::bid(4, 7)); liars_dice::do_not_optimize(game_); }));
+  results.emplace_back(liars_dice::run_benchmark("game::masked_game", [&]() { liars_dice::do_not_optimize(game.masked_game()); }));
+  results.emplace_back(liars_dice::run_benchmark("game::masked_game (in place)", [&, masked_game = game.masked_game()]() mutable { game.masked_game(masked_game); liars_dice::do_not_optimize(masked_game); }));
+  results.emplace_back(liars_dice::run_benchmark("game::hash", [&]() { liars_dice::do_not_optimize(game.hash()); }));
+  results.emplace_back(liars_dice::run_benchmark("game::dice_count_deltas", [&]() { liars_dice::do_not_optimize(ended_game.dice_count_deltas()); }));
+
+  [&]() {
+    auto fool_      = fool();
+    auto hardhead_  = hardhead();
+    auto optimist_  = optimist();
+    auto pessimist_ = pessimist();
+    auto timid_     = timid();
+
+    const auto& ids         = std::vector<std::string>{"A", "B", "C", "D", "E", "F"};
+    const auto& dice_counts = std::vector<int>{5, 5, 5, 5, 5, 5};
+
+    const auto& action_functions = std::vector<std::function<liars_dice::action(const liars_dice::game&)>>{
+      [&](const auto& game) { return fool_.action(game); },
+      [&](const auto& game) { return hardhead_.action(game); },
+      [&](const auto& game) { return optimist_.action(game); },
+      [&](const auto& game) { return pessimist_.action(game); },
+      [&](const auto& game) { return timid_.action(game); },
+      [&](const auto& game) { return hardhead_.action(game); }};
+
+    results.emplace_back(liars_dice::run_benchmark("play_game (6 in-process programs)", [&]() { liars_dice::do_not_optimize(liars_dice::play_game(ids, dice_counts, action_functions)); }));
+
+    // サンプル・プログラム
+
+    const auto& masked_game = game.masked_game();
+
+    results.emplace_back(liars_dice::run_benchmark("fool::action", [&]() { liars_dice::do_not_optimize(fool_.action(masked_game)); }));
+    results.emplace_back(liars_dice::run_benchmark("hardhead::action", [&]() { liars_dice::do_not_optimize(hardhead_.action(masked_game)); }));
+    results.emplace_back(liars_dice::run_benchmark("optimist::action", [&]() { liars_dice::do_not_optimize(optimist_.action(masked_game)); }));
+    results.emplace_back(liars_dice::run_benchmark("pessimist::action", [&]() { liars_dice::do_not_optimize(pessimist_.action(masked_game)); }));
+    results.emplace_back(liars_dice::run_benchmark("timid::action", [&]() { liars_dice::do_not_optimize(timid_.action(masked_game)); }));
+  }();
+
+  // belief.hpp
+
+  [&]() {
+    const auto& masked_game = game.masked_game();
+
+    auto belief_tracker = liars_dice::belief_tracker();
+
+    results.emplace_back(liars_dice::run_benchmark("belief_tracker reset + update (10 bids)", [&]() { belief_tracker.reset(masked_game); belief_tracker.update(masked_game); liars_dice::do_not_optimize(belief_tracker); }));
+    results.emplace_back(liars_dice::run_benchmark("belief_tracker::probability", [&]() { liars_dice::do_not_optimize(belief_tracker.probability(liars_dice::bid(3, 8))); }));
+  }();
+
+  // transposition_table.hpp
+
+  [&]() {
+    auto transposition_table = liars_dice::transposition_table(64 * 1024 * 1024);
+    auto random_engine       = std::mt19937_64(0);
+
+    results.emplace_back(liars_dice::run_benchmark("transposition_table::store + find", [&]() { const auto& hash = random_engine(); transposition_table.store(hash, liars_dice::transposition_entry{1, 0.5f}); liars_dice::do_not_optimize(transposition_table.find(hash)); }));
+  }();
+
+  // json.hpp
+
+  results.emplace_back(liars_dice::run_benchmark("write_game (6 players)", [&]() { liars_dice::do_not_optimize(liars_dice::write_json(game, std::function(liars_dice::write_game))); }));
+  results.emplace_back(liars_dice::run_benchmark("read_game (6 players)", [&]() { liars_dice::do_not_optimize(liars_dice::read_json(game_json, std::function(liars_dice::read_game))); }));
+  results.emplace_back(liars_dice::run_benchmark("read_game_in_place (6 players)", [&, game_ = game]() mutable { liars_dice::read_json(game_json, game_, std::function(liars_dice::read_game_in_place)); liars_dice::do_not_optimize(game_); }));
+  results.emplace_back(liars_dice::run_benchmark("write_careers (6 x 100 records)", [&]() { liars_dice::do_not_optimize(liars_dice::write_json(careers, std::function(liars_dice::write_careers))); }, 5));
+  results.emplace_back(liars_dice::run_benchmark("read_careers (6 x 100 records)", [&]() { liars_dice::do_not_optimize(liars_dice::read_json(careers_json, std::function(liars_dice::read_careers))); }, 5));
+
+  // classifier.hpp
+
+  [&]() {
+    const auto& classifier = sample_classifier();
+
+    results.emplace_back(liars_dice::run_benchmark("classify_careers (6 x 100 records)", [&]() { liars_dice::do_not_optimize(liars_dice::classify_careers(classifier, careers)); }, 5));
+  }();
+
+  // 結果を、機械で読める形で出力します。
+
+  const auto& results_json = liars_dice::write_json(results, std::function(liars_dice::write_benchmark_results));
+
+  if (argc == 2) {
+    auto ofstream = std::ofstream(argv[1]);
+    ofstream << results_json << std::endl;
+    ofstream.close();
+
+  } else {
+    std::cout << results_json << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,217 @@
+﻿#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "../game.hpp"
+#include "../../fool/fool.hpp"
+#include "../../hardhead/hardhead.hpp"
+#include "../../optimist/optimist.hpp"
+#include "../../pessimist/pessimist.hpp"
+#include "../../timid/timid.hpp"
+#include "liars_dice.h"
+
+struct liars_dice_game final {
+  liars_dice::game game;
+};
+
+namespace {
+  auto decode_action(int action) noexcept {
+    return action == LIARS_DICE_CHALLENGE ? liars_dice::action(liars_dice::challenge()) : liars_dice::action(liars_dice::bid(action % 8, action / 8));
+  }
+
+  auto encode_action(const liars_dice::action& action) noexcept {
+    return action.bid() ? action.bid()->min_count() * 8 + action.bid()->face() : LIARS_DICE_CHALLENGE;
+  }
+
+  auto game_action_count(const liars_dice::game& game) noexcept {
+    return boost::accumulate(game.players() | boost::adaptors::transformed([](const auto& player) { return static_cast<int>(std::size(player.actions())); }), 0);
+  }
+
+  // 手を打たれた順に書き込みます。ゲームは、最初のプレイヤーが最初に宣言しています。
+  auto write_actions(const liars_dice::game& game, int* actions) noexcept {
+    const auto& player_count = static_cast<int>(std::size(game.players()));
+
+    for (auto i = 0; i < game_action_count(game); ++i) {
+      actions[i] = encode_action(game.players()[i % player_count].actions()[i / player_count]);
+    }
+  }
+
+  // サンプル・プログラムは乱数の状態を持っているので、スレッド毎に作成します。
+  auto policy_action_function(int policy) -> std::function<liars_dice::action(const liars_dice::game&)> {
+    thread_local auto fool_      = fool();
+    thread_local auto hardhead_  = hardhead();
+    thread_local auto optimist_  = optimist();
+    thread_local auto pessimist_ = pessimist();
+    thread_local auto timid_     = timid();
+
+    switch (policy) {
+    case LIARS_DICE_POLICY_FOOL:
+      return [](const auto& game) { return fool_.action(game); };
+    case LIARS_DICE_POLICY_HARDHEAD:
+      return [](const auto& game) { return hardhead_.action(game); };
+    case LIARS_DICE_POLICY_OPTIMIST:
+      return [](const auto& game) { return optimist_.action(game); };
+    case LIARS_DICE_POLICY_PESSIMIST:
+      return [](const auto& game) { return pessimist_.action(game); };
+    case LIARS_DICE_POLICY_TIMID:
+      return [](const auto& game) { return timid_.action(game); };
+    }
+
+    return nullptr;
+  }
+}
+
+extern "C" {
+  int liars_dice_abi_version(void) {
+    return LIARS_DICE_ABI_VERSION;
+  }
+
+  liars_dice_game* liars_dice_game_create(int player_count, const int* dice_counts, const int* faces, int max_bid_count) {
+    if (player_count < 2 || !dice_counts || !faces || max_bid_count < 1) {
+      return nullptr;
+    }
+
+    try {
+      auto players = std::vector<liars_dice::player>(); players.reserve(player_count);
+
+      for (auto i = 0, j = 0; i < player_count; j += dice_counts[i++]) {
+        if (dice_counts[i] < 1 || std::any_of(faces + j, faces + j + dice_counts[i], [](const auto& face) { return face < 1 || face > 6; })) {
+          return nullptr;
+        }
+
+        players.emplace_back(std::to_string(i), std::vector<int>(faces + j, faces + j + dice_counts[i]));
+      }
+
+      return new liars_dice_game{liars_dice::game(players, 0, max_bid_count)};
+
+    } catch (...) {
+      return nullptr;
+    }
+  }
+
+  void liars_dice_game_destroy(liars_dice_game* game) {
+    delete game;
+  }
+
+  int liars_dice_game_player_index(const liars_dice_game* game) {
+    if (!game) {
+      return LIARS_DICE_ERROR_INVALID_ARGUMENT;
+    }
+
+    return game->game.player_index();
+  }
+
+  int liars_dice_game_is_legal_action(const liars_dice_game* game, int action) {
+    if (!game) {
+      return LIARS_DICE_ERROR_INVALID_ARGUMENT;
+    }
+
+    return !game->game.is_end() && game->game.is_legal_action(decode_action(action)) ? 1 : 0;
+  }
+
+  int liars_dice_game_do_action(liars_dice_game* game, int action) {
+    if (!game) {
+      return LIARS_DICE_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (game->game.is_end() || !game->game.is_legal_action(decode_action(action))) {
+      return LIARS_DICE_ERROR_ILLEGAL_ACTION;
+    }
+
+    game->game.do_action(decode_action(action));
+
+    return 0;
+  }
+
+  int liars_dice_game_is_end(const liars_dice_game* game) {
+    if (!game) {
+      return LIARS_DICE_ERROR_INVALID_ARGUMENT;
+    }
+
+    return game->game.is_end() ? 1 : 0;
+  }
+
+  int liars_dice_game_actions(const liars_dice_game* game, int* actions, int capacity) {
+    if (!game || !actions) {
+      return LIARS_DICE_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (capacity < game_action_count(game->game)) {
+      return LIARS_DICE_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    write_actions(game->game, actions);
+
+    return game_action_count(game->game);
+  }
+
+  int liars_dice_game_dice_count_deltas(const liars_dice_game* game, int* deltas, int capacity) {
+    if (!game || !deltas || !game->game.is_end()) {
+      return LIARS_DICE_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (capacity < static_cast<int>(std::size(game->game.players()))) {
+      return LIARS_DICE_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    const auto& dice_count_deltas = game->game.dice_count_deltas();
+
+    std::copy(std::begin(dice_count_deltas), std::end(dice_count_deltas), deltas);
+
+    return static_cast<int>(std::size(dice_count_deltas));
+  }
+
+  int liars_dice_play_game(int player_count, const int* dice_counts, const int* policies, uint64_t seed, int max_bid_count, int* faces, int faces_capacity, int* actions, int actions_capacity, int* action_count, int* deltas) {
+    if (player_count < 2 || !dice_counts || !policies || max_bid_count < 1 || !faces || !actions || !action_count || !deltas) {
+      return LIARS_DICE_ERROR_INVALID_ARGUMENT;
+    }
+
+    try {
+      auto ids              = std::vector<std::string>();                                                ids.reserve(player_count);
+      auto action_functions = std::vector<std::function<liars_dice::action(const liars_dice::game&)>>(); action_functions.reserve(player_count);
+
+      for (auto i = 0; i < player_count; ++i) {
+        if (dice_counts[i] < 1 || !policy_action_function(policies[i])) {
+          return LIARS_DICE_ERROR_INVALID_ARGUMENT;
+        }
+
+        ids.emplace_back(std::to_string(i));
+        action_functions.emplace_back(policy_action_function(policies[i]));
+      }
+
+      if (faces_capacity < std::accumulate(dice_counts, dice_counts + player_count, 0)) {
+        return LIARS_DICE_ERROR_BUFFER_TOO_SMALL;
+      }
+
+      const auto& [game, dice_count_deltas] = liars_dice::play_game(ids, std::vector<int>(dice_counts, dice_counts + player_count), action_functions, seed, max_bid_count);
+
+      if (actions_capacity < game_action_count(game)) {
+        return LIARS_DICE_ERROR_BUFFER_TOO_SMALL;
+      }
+
+      auto it = faces;
+
+      for (const auto& player: game.players()) {
+        it = std::copy(std::begin(player.faces()), std::end(player.faces()), it);
+      }
+
+      write_actions(game, actions);
+
+      *action_count = game_action_count(game);
+
+      std::copy(std::begin(dice_count_deltas), std::end(dice_count_deltas), deltas);
+
+      // 終了していないのは、play_gameが戦略の違法な手（-91）か例外（-92）で打ち切った場合です。
+      if (!game.is_end()) {
+        return LIARS_DICE_ERROR_ILLEGAL_ACTION;
+      }
+
+      return 0;
+
+    } catch (...) {
+      return LIARS_DICE_ERROR_INVALID_ARGUMENT;
+    }
+  }
+}
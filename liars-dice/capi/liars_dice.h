@@ -0,0 +1,78 @@
+﻿#pragma once
+
+#include <stdint.h>
+
+// liars-dice-capi（libliars-dice.so）のCのAPI。Pythonのctypesなどから、ディーラーを起動せずに、プロセス内でゲームを作成したり実行したりできます。
+// 結果は全て呼び出し側が用意したバッファーに書き込むので、ライブラリ側で確保したメモリを解放する必要があるのは、liars_dice_game_createの戻り値だけです。
+//
+// 手は整数で表現します。宣言は個数 * 8 + 目（game_log.hppと同じ形式）、チャレンジはLIARS_DICE_CHALLENGEです。
+// 戻り値が負の値の関数は、LIARS_DICE_ERROR_*のエラーを表します。
+//
+// Pythonからの使い方の例:
+//   lib = ctypes.CDLL('./libliars-dice.so')
+//   dice_counts = (ctypes.c_int * 6)(5, 5, 5, 5, 5, 5)
+//   policies = (ctypes.c_int * 6)(0, 1, 2, 3, 4, 1)
+//   faces, actions, action_count, deltas = (ctypes.c_int * 30)(), (ctypes.c_int * 256)(), ctypes.c_int(), (ctypes.c_int * 6)()
+//   lib.liars_dice_play_game(6, dice_counts, policies, ctypes.c_uint64(seed), 20, faces, 30, actions, 256, ctypes.byref(action_count), deltas)
+
+#ifdef _WIN32
+#define LIARS_DICE_API __declspec(dllexport)
+#else
+#define LIARS_DICE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LIARS_DICE_ABI_VERSION 1
+
+#define LIARS_DICE_CHALLENGE 0
+
+#define LIARS_DICE_ERROR_INVALID_ARGUMENT -1
+#define LIARS_DICE_ERROR_BUFFER_TOO_SMALL -2
+#define LIARS_DICE_ERROR_ILLEGAL_ACTION   -3
+
+// liars_dice_play_gameで使用できる、サンプル・プログラムの戦略。
+#define LIARS_DICE_POLICY_FOOL      0
+#define LIARS_DICE_POLICY_HARDHEAD  1
+#define LIARS_DICE_POLICY_OPTIMIST  2
+#define LIARS_DICE_POLICY_PESSIMIST 3
+#define LIARS_DICE_POLICY_TIMID     4
+
+typedef struct liars_dice_game liars_dice_game;
+
+// ヘッダーとライブラリの版が一致しているかを確認するために使用します。
+LIARS_DICE_API int liars_dice_abi_version(void);
+
+// facesは、席の順に全員のダイスの目を並べたもの（dice_countsの合計の長さ）です。ダイスの数は1以上、目は1〜6でなければなりません。失敗した場合はNULLを返します。
+LIARS_DICE_API liars_dice_game* liars_dice_game_create(int player_count, const int* dice_counts, const int* faces, int max_bid_count);
+
+LIARS_DICE_API void liars_dice_game_destroy(liars_dice_game* game);
+
+LIARS_DICE_API int liars_dice_game_player_index(const liars_dice_game* game);
+
+// 合法なら1、違法なら0を返します。
+LIARS_DICE_API int liars_dice_game_is_legal_action(const liars_dice_game* game, int action);
+
+// 違法な手の場合は、何もせずにLIARS_DICE_ERROR_ILLEGAL_ACTIONを返します。
+LIARS_DICE_API int liars_dice_game_do_action(liars_dice_game* game, int action);
+
+// 終了していれば1、していなければ0を返します。
+LIARS_DICE_API int liars_dice_game_is_end(const liars_dice_game* game);
+
+// 手を、打たれた順にactionsに書き込んで、手の数を返します。
+LIARS_DICE_API int liars_dice_game_actions(const liars_dice_game* game, int* actions, int capacity);
+
+// 終了したゲームの、席毎のダイスの増減をdeltasに書き込んで、プレイヤーの数を返します。
+LIARS_DICE_API int liars_dice_game_dice_count_deltas(const liars_dice_game* game, int* deltas, int capacity);
+
+// policiesの戦略でゲームを実行します。ダイスの目はseedから決まります（ディーラーのplay_gameと同じ）。
+// facesに全員のダイスの目を、actionsに打たれた順の手を、action_countに手の数を、deltasに席毎のダイスの増減を書き込んで、0を返します。
+// 戦略が違法な手を打った場合（max_bid_countが小さくてfoolの最初の宣言が上限を超える場合など）は、ゲームはその手番で打ち切られてLIARS_DICE_ERROR_ILLEGAL_ACTIONを返します。
+// その場合も各バッファーには書き込みますが、actionsに違法な手は含まれず、deltasはディーラーと同じく、違法な手を打った席が-91（例外の場合は-92）、他の席が0になります。
+LIARS_DICE_API int liars_dice_play_game(int player_count, const int* dice_counts, const int* policies, uint64_t seed, int max_bid_count, int* faces, int faces_capacity, int* actions, int actions_capacity, int* action_count, int* deltas);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,377 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <rapidjson/document.h>
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "game.hpp"
+#include "game_log.hpp"
+#include "json.hpp"
+
+namespace liars_dice {
+  // メモリにマップして読む、戦歴のファイル。check_other_programsの戦歴はセットの全員に同じものを送るのに、JSONだとプログラム毎に送ってパースし直すことになるので、
+  // ディーラーがセット毎に一度だけこの形式で書いて、プログラムにはパスと世代番号だけを通知します。プログラムは、ビュー経由でコピーせずに読めます。
+  // 数値は全てリトル・エンディアンで、オフセットはファイルの先頭からです（プレイヤーのオフセットだけは、ゲームの先頭から）。
+  //
+  // ヘッダー（32バイト）: "LDCAREE"、バージョン（1バイト）、世代番号（8バイト）、戦歴の数（4バイト）、索引のオフセット（8バイト）、予備（4バイト）
+  // 戦歴:                IDの長さ（2バイト）、ID、記録の数（4バイト）、記録毎のオフセット（8バイトずつ）
+  // 記録:                IDの長さ（2バイト）、ID、ゲーム
+  // ゲーム:              プレイヤーの数（2バイト）、手番（2バイト）、宣言の上限（2バイト）、予備（2バイト）、プレイヤー毎のオフセット（4バイトずつ）
+  // プレイヤー:          IDの長さ（2バイト）、ダイスの数（2バイト）、手の数（2バイト）、ID、ダイスの目（1バイトずつ）、手（2バイトずつ。game_log.hppと同じ形式）
+  // 索引:                戦歴毎のオフセット（8バイトずつ）
+
+  constexpr auto career_map_magic       = "LDCAREE";
+  constexpr auto career_map_version     = 1;
+  constexpr auto career_map_header_size = 32;
+
+  // プログラムに通知する、戦歴のファイルの場所。
+  struct career_map_location final {
+    std::string path;
+    std::uint64_t generation;
+  };
+
+  // ビュー。どれもマップしたメモリを指しているだけなので、career_mapより長生きさせてはいけません。
+
+  class player_view final {
+    const char* _data;
+
+    auto id_length() const noexcept {
+      return static_cast<int>(get_uint(_data + 0, 2));
+    }
+
+  public:
+    player_view(const char* data) noexcept: _data(data) {
+      ;
+    }
+
+    auto id() const noexcept {
+      return std::string_view(_data + 6, id_length());
+    }
+
+    auto dice_count() const noexcept {
+      return static_cast<int>(get_uint(_data + 2, 2));
+    }
+
+    auto action_count() const noexcept {
+      return static_cast<int>(get_uint(_data + 4, 2));
+    }
+
+    auto face(int index) const noexcept {
+      return static_cast<int>(static_cast<unsigned char>(_data[6 + id_length() + index]));
+    }
+
+    auto action(int index) const noexcept {
+      const auto& value = static_cast<int>(get_uint(_data + 6 + id_length() + dice_count() + index * 2, 2));
+
+      return value == game_log_challenge ? liars_dice::action(challenge()) : liars_dice::action(bid(value % 8, value / 8));
+    }
+
+    auto to_player() const noexcept {
+      auto faces = std::vector<int>(); faces.reserve(dice_count());
+
+      for (auto i = 0; i < dice_count(); ++i) {
+        faces.emplace_back(face(i));
+      }
+
+      auto actions = std::vector<liars_dice::action>(); actions.reserve(action_count());
+
+      for (auto i = 0; i < action_count(); ++i) {
+        actions.emplace_back(action(i));
+      }
+
+      return player(std::string(id()), faces, actions);
+    }
+  };
+
+  class game_view final {
+    const char* _data;
+
+  public:
+    game_view(const char* data) noexcept: _data(data) {
+      ;
+    }
+
+    auto player_count() const noexcept {
+      return static_cast<int>(get_uint(_data + 0, 2));
+    }
+
+    auto player_index() const noexcept {
+      return static_cast<int>(get_uint(_data + 2, 2));
+    }
+
+    auto max_bid_count() const noexcept {
+      return static_cast<int>(get_uint(_data + 4, 2));
+    }
+
+    auto player(int index) const noexcept {
+      return player_view(_data + get_uint(_data + 8 + index * 4, 4));
+    }
+
+    auto to_game() const noexcept {
+      auto players = std::vector<liars_dice::player>(); players.reserve(player_count());
+
+      for (auto i = 0; i < player_count(); ++i) {
+        players.emplace_back(player(i).to_player());
+      }
+
+      return game(players, player_index(), max_bid_count());
+    }
+  };
+
+  class career_record_view final {
+    const char* _data;
+
+  public:
+    career_record_view(const char* data) noexcept: _data(data) {
+      ;
+    }
+
+    auto id() const noexcept {
+      return std::string_view(_data + 2, static_cast<std::size_t>(get_uint(_data, 2)));
+    }
+
+    auto game() const noexcept {
+      return game_view(_data + 2 + get_uint(_data, 2));
+    }
+
+    auto to_career_record() const noexcept {
+      return career_record{std::string(id()), game().to_game()};
+    }
+  };
+
+  class career_view final {
+    const char* _base;
+    const char* _data;
+
+    auto id_length() const noexcept {
+      return static_cast<int>(get_uint(_data, 2));
+    }
+
+  public:
+    career_view(const char* base, const char* data) noexcept: _base(base), _data(data) {
+      ;
+    }
+
+    auto id() const noexcept {
+      return std::string_view(_data + 2, id_length());
+    }
+
+    auto size() const noexcept {
+      return static_cast<int>(get_uint(_data + 2 + id_length(), 4));
+    }
+
+    auto career_record(int index) const noexcept {
+      return career_record_view(_base + get_uint(_data + 2 + id_length() + 4 + index * 8, 8));
+    }
+
+    auto to_career() const noexcept {
+      auto career_records = std::vector<liars_dice::career_record>(); career_records.reserve(size());
+
+      for (auto i = 0; i < size(); ++i) {
+        career_records.emplace_back(career_record(i).to_career_record());
+      }
+
+      return career{std::string(id()), career_records};
+    }
+  };
+
+  // object -> binary
+
+  inline auto write_career_map(const std::vector<career>& careers, std::uint64_t generation) {
+    const auto& put_id = [](std::string& buffer, const std::string& id) {
+      put_checked_uint(buffer, std::size(id), 2, "id length");
+      buffer.append(id);
+    };
+
+    auto body           = std::string();
+    auto career_offsets = std::vector<std::uint64_t>(); career_offsets.reserve(std::size(careers));
+
+    for (const auto& career: careers) {
+      // 記録のオフセットは、記録を書くまで分からないので、先に記録を書きます。
+      auto career_record_offsets = std::vector<std::uint64_t>(); career_record_offsets.reserve(std::size(career.career_records));
+
+      for (const auto& career_record: career.career_records) {
+        career_record_offsets.emplace_back(career_map_header_size + std::size(body));
+
+        put_id(body, career_record.id);
+
+        // プレイヤーのオフセットは、プレイヤーを書くまで分からないので、先にプレイヤーを書きます。
+        auto players        = std::string();
+        auto player_offsets = std::vector<std::uint64_t>(); player_offsets.reserve(std::size(career_record.game.players()));
+
+        for (const auto& player: career_record.game.players()) {
+          player_offsets.emplace_back(8 + std::size(career_record.game.players()) * 4 + std::size(players));
+
+          put_checked_uint(players, std::size(player.id()), 2, "id length");
+          put_checked_uint(players, std::size(player.faces()), 2, "dice count");
+          put_checked_uint(players, std::size(player.actions()), 2, "action count");
+          players.append(player.id());
+
+          for (const auto& face: player.faces()) {
+            players.push_back(static_cast<char>(face));
+          }
+
+          for (const auto& action: player.actions()) {
+            put_action(players, action);
+          }
+        }
+
+        put_checked_uint(body, std::size(career_record.game.players()), 2, "player count");
+        put_checked_uint(body, career_record.game.player_index(), 2, "player index");
+        put_checked_uint(body, career_record.game.max_bid_count(), 2, "max bid count");
+        put_uint(body, 0, 2);
+
+        for (const auto& player_offset: player_offsets) {
+          put_uint(body, player_offset, 4);
+        }
+
+        body.append(players);
+      }
+
+      career_offsets.emplace_back(career_map_header_size + std::size(body));
+
+      put_id(body, career.id);
+      put_uint(body, std::size(career_record_offsets), 4);
+
+      for (const auto& career_record_offset: career_record_offsets) {
+        put_uint(body, career_record_offset, 8);
+      }
+    }
+
+    auto result = std::string(career_map_magic);
+
+    result.push_back(static_cast<char>(career_map_version));
+    put_uint(result, generation, 8);
+    put_uint(result, std::size(careers), 4);
+    put_uint(result, career_map_header_size + std::size(body), 8);
+    put_uint(result, 0, 4);
+
+    result.append(body);
+
+    for (const auto& career_offset: career_offsets) {
+      put_uint(result, career_offset, 8);
+    }
+
+    return result;
+  }
+
+  // binary -> object
+
+  class career_map final {
+    boost::interprocess::file_mapping _file_mapping;
+    boost::interprocess::mapped_region _mapped_region;
+    const char* _data;
+
+  public:
+    career_map(const std::string& path_string): _file_mapping(path_string.c_str(), boost::interprocess::read_only), _mapped_region(_file_mapping, boost::interprocess::read_only), _data(static_cast<const char*>(_mapped_region.get_address())) {
+      if (_mapped_region.get_size() < career_map_header_size || std::string(_data, 7) != career_map_magic || _data[7] != career_map_version) {
+        throw std::runtime_error("not a career map: " + path_string);
+      }
+    }
+
+    // 通知された世代番号と違う場合は、ファイルが書き換えられているので例外にします。
+    career_map(const career_map_location& career_map_location): career_map(career_map_location.path) {
+      if (get_uint(_data + 8, 8) != career_map_location.generation) {
+        throw std::runtime_error("stale career map: " + career_map_location.path);
+      }
+    }
+
+    auto generation() const noexcept {
+      return get_uint(_data + 8, 8);
+    }
+
+    auto size() const noexcept {
+      return static_cast<int>(get_uint(_data + 16, 4));
+    }
+
+    auto career(int index) const noexcept {
+      return career_view(_data, _data + get_uint(_data + get_uint(_data + 20, 8) + index * 8, 8));
+    }
+
+    // 全てをコピーして、check_other_programsと同じ形にします。
+    auto careers() const noexcept {
+      auto result = std::vector<liars_dice::career>(); result.reserve(size());
+
+      for (auto i = 0; i < size(); ++i) {
+        result.emplace_back(career(i).to_career());
+      }
+
+      return result;
+    }
+  };
+
+  // object -> json
+
+  inline auto write_career_map_location(const career_map_location& career_map_location, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartObject();
+    writer.Key("path");
+    writer.String(career_map_location.path.c_str());
+    writer.Key("generation");
+    writer.Uint64(career_map_location.generation);
+    writer.EndObject();
+  }
+
+  // json -> object
+
+  inline auto read_career_map_location(const rapidjson::Value& value) noexcept {
+    return career_map_location{value["path"].GetString(), value["generation"].GetUint64()};
+  }
+
+  // file
+
+  // 前のセットのプログラムがマップしたままでも壊れないように、別のファイルに書いてから置き換えます。
+  // Windowsではマップされたままのファイルは置き換えられないので、書けなかった場合はfalseを返します。その場合は、JSONで戦歴を送ってください。
+  inline auto write_career_map_file(const std::string& path_string, const std::vector<career>& careers, std::uint64_t generation) noexcept {
+    const auto& report = [&](const auto& message) {
+      std::cerr << "*** CANNOT WRITE CAREER MAP to " << path_string << ": " << message << " ***" << std::endl;
+    };
+
+    const auto& temporary_path_string = path_string + ".tmp";
+
+    auto ofstream = std::ofstream(temporary_path_string, std::ios::out | std::ios::binary);
+
+    try {
+      ofstream << write_career_map(careers, generation);
+    } catch (const std::exception& exception) {  // 固定長のフィールドに収まらない場合です。
+      report(exception.what());
+
+      return false;
+    }
+
+    ofstream.close();
+
+    if (!ofstream) {
+      report("cannot write " + temporary_path_string);
+
+      return false;
+    }
+
+    auto error_code = boost::system::error_code();
+
+    boost::filesystem::rename(temporary_path_string, path_string, error_code);
+
+    if (error_code) {
+      report(error_code.message());
+
+      return false;
+    }
+
+    return true;
+  }
+}
@@ -0,0 +1,272 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/range/adaptors.hpp>
+#include <boost/range/numeric.hpp>
+#include <rapidjson/document.h>
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "game.hpp"
+#include "json.hpp"
+
+namespace liars_dice {
+  // プログラムの戦歴の集計値。ディーラーがゲームの終了時に足し込んでいくので、プログラムは生の戦歴を読んで集計し直さなくても、性格診断に使えます。
+  //
+  // 「見込み」は、自分のダイスの中のその目（1の目を含む）の数 + 他のプレイヤーのダイスの数 / 3です。宣言の個数 / 見込みの比は、ratio_boundsで区間に分けて数えます。
+  class career_statistics final {
+  public:
+    static constexpr auto ratio_bounds       = std::array<double, 6>{0.5, 0.75, 1.0, 1.25, 1.5, 2.0};
+    static constexpr auto ratio_bucket_count = static_cast<int>(std::size(ratio_bounds)) + 1;
+
+  private:
+    int _game_count;
+    std::array<int, 7> _opening_face_counts;                        // 最初の宣言の、目毎の回数。
+    std::array<int, ratio_bucket_count> _opening_ratio_counts;     // 最初の宣言の、個数 / 見込みの区間毎の回数。
+    std::array<int, ratio_bucket_count> _decision_counts;          // 直前の宣言の、個数 / 自分の見込みの区間毎の、手番の回数。
+    std::array<int, ratio_bucket_count> _challenge_counts;         // 同じく、チャレンジした回数。
+    int _bid_count;
+    int _bluff_count;                                              // 自分のダイスに、その目も1の目もない宣言の回数。
+    int _raise_count;
+    int _total_raise_size;                                         // 直前の宣言からの、宣言の番号（bid_index()）の増分の合計。
+
+  public:
+    static auto ratio_bucket_index(double ratio) noexcept {
+      return static_cast<int>(std::upper_bound(std::begin(ratio_bounds), std::end(ratio_bounds), ratio) - std::begin(ratio_bounds));
+    }
+
+    career_statistics(int game_count, const std::array<int, 7>& opening_face_counts, const std::array<int, ratio_bucket_count>& opening_ratio_counts, const std::array<int, ratio_bucket_count>& decision_counts, const std::array<int, ratio_bucket_count>& challenge_counts, int bid_count, int bluff_count, int raise_count, int total_raise_size) noexcept:
+      _game_count(game_count),
+      _opening_face_counts(opening_face_counts),
+      _opening_ratio_counts(opening_ratio_counts),
+      _decision_counts(decision_counts),
+      _challenge_counts(challenge_counts),
+      _bid_count(bid_count),
+      _bluff_count(bluff_count),
+      _raise_count(raise_count),
+      _total_raise_size(total_raise_size)
+    {
+      ;
+    }
+
+    career_statistics() noexcept: career_statistics(0, {}, {}, {}, {}, 0, 0, 0, 0) {
+      ;
+    }
+
+    const auto& game_count() const noexcept {
+      return _game_count;
+    }
+
+    const auto& opening_face_counts() const noexcept {
+      return _opening_face_counts;
+    }
+
+    const auto& opening_ratio_counts() const noexcept {
+      return _opening_ratio_counts;
+    }
+
+    const auto& decision_counts() const noexcept {
+      return _decision_counts;
+    }
+
+    const auto& challenge_counts() const noexcept {
+      return _challenge_counts;
+    }
+
+    const auto& bid_count() const noexcept {
+      return _bid_count;
+    }
+
+    const auto& bluff_count() const noexcept {
+      return _bluff_count;
+    }
+
+    const auto& raise_count() const noexcept {
+      return _raise_count;
+    }
+
+    const auto& total_raise_size() const noexcept {
+      return _total_raise_size;
+    }
+
+    // 直前の宣言の、個数 / 自分の見込みがbucket_indexの区間だった場合に、チャレンジした割合。
+    auto challenge_rate(int bucket_index) const noexcept {
+      return _decision_counts[bucket_index] > 0 ? static_cast<double>(_challenge_counts[bucket_index]) / _decision_counts[bucket_index] : 0.0;
+    }
+
+    auto bluff_rate() const noexcept {
+      return _bid_count > 0 ? static_cast<double>(_bluff_count) / _bid_count : 0.0;
+    }
+
+    auto average_raise_size() const noexcept {
+      return _raise_count > 0 ? static_cast<double>(_total_raise_size) / _raise_count : 0.0;
+    }
+
+    // player_indexの席のプレイヤーとして、ゲームを足し込みます。gameは、ダイスの目が隠されていない、最初のプレイヤーが最初に宣言したゲームでなければなりません。
+    auto add_game(const game& game, int player_index) noexcept {
+      const auto& player_count = static_cast<int>(std::size(game.players()));
+      const auto& faces        = game.players()[player_index].faces();
+
+      const auto& secret_dice_count = boost::accumulate(game.players() | boost::adaptors::transformed([](const auto& player) { return static_cast<int>(std::size(player.faces())); }), 0) - static_cast<int>(std::size(faces));
+
+      const auto& own_count = [&](int face) {
+        return static_cast<int>(std::count_if(std::begin(faces), std::end(faces), [&](const auto& face_) { return face_ == 1 || face_ == face; }));
+      };
+
+      const auto& ratio = [&](const bid& bid) {
+        const auto& estimate = own_count(bid.face()) + secret_dice_count / 3.0;
+
+        return estimate > 0 ? bid.min_count() / estimate : std::numeric_limits<double>::infinity();
+      };
+
+      _game_count++;
+
+      for (auto i = 0; i < static_cast<int>(std::size(game.players()[player_index].actions())); ++i) {
+        const auto& action_index = i * player_count + player_index;
+        const auto& action       = game.players()[player_index].actions()[i];
+
+        const auto& previous_bid = [&]() -> std::optional<bid> {
+          if (action_index == 0) {
+            return std::nullopt;
+          }
+
+          return game.players()[(action_index - 1) % player_count].actions()[(action_index - 1) / player_count].bid();
+        }();
+
+        if (previous_bid) {
+          const auto& bucket_index = ratio_bucket_index(ratio(previous_bid.value()));
+
+          _decision_counts[bucket_index]++;
+
+          if (action.challenge()) {
+            _challenge_counts[bucket_index]++;
+          }
+        }
+
+        if (!action.bid()) {
+          continue;
+        }
+
+        const auto& bid = action.bid().value();
+
+        _bid_count++;
+
+        if (own_count(bid.face()) == 0) {
+          _bluff_count++;
+        }
+
+        if (!previous_bid) {
+          _opening_face_counts[bid.face()]++;
+          _opening_ratio_counts[ratio_bucket_index(ratio(bid))]++;
+
+          continue;
+        }
+
+        _raise_count++;
+        _total_raise_size += bid_index(bid) - bid_index(previous_bid.value());
+      }
+    }
+  };
+
+  // セット内のIDと、そのプログラムの戦歴の集計値。
+  struct career_summary final {
+    std::string id;
+    career_statistics statistics;
+  };
+
+  // object -> json
+
+  template<std::size_t N>
+  inline auto write_int_array(const std::array<int, N>& values, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartArray();
+    for (const auto& value: values) {
+      writer.Int(value);
+    }
+    writer.EndArray();
+  }
+
+  inline auto write_career_statistics(const career_statistics& career_statistics, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartObject();
+    writer.Key("game_count");
+    writer.Int(career_statistics.game_count());
+    writer.Key("opening_face_counts");
+    write_int_array(career_statistics.opening_face_counts(), writer);
+    writer.Key("opening_ratio_counts");
+    write_int_array(career_statistics.opening_ratio_counts(), writer);
+    writer.Key("decision_counts");
+    write_int_array(career_statistics.decision_counts(), writer);
+    writer.Key("challenge_counts");
+    write_int_array(career_statistics.challenge_counts(), writer);
+    writer.Key("bid_count");
+    writer.Int(career_statistics.bid_count());
+    writer.Key("bluff_count");
+    writer.Int(career_statistics.bluff_count());
+    writer.Key("raise_count");
+    writer.Int(career_statistics.raise_count());
+    writer.Key("total_raise_size");
+    writer.Int(career_statistics.total_raise_size());
+    writer.EndObject();
+  }
+
+  inline auto write_career_summaries(const std::vector<career_summary>& career_summaries, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartArray();
+    for (const auto& career_summary: career_summaries) {
+      writer.StartObject();
+      writer.Key("id");
+      writer.String(career_summary.id.c_str());
+      writer.Key("statistics");
+      write_career_statistics(career_summary.statistics, writer);
+      writer.EndObject();
+    }
+    writer.EndArray();
+  }
+
+  // json -> object
+
+  template<std::size_t N>
+  inline auto read_int_array(const rapidjson::Value& value) noexcept {
+    auto result = std::array<int, N>{};
+
+    for (auto i = 0; i < static_cast<int>(std::min(static_cast<std::size_t>(value.Size()), N)); ++i) {
+      result[i] = value[i].GetInt();
+    }
+
+    return result;
+  }
+
+  inline auto read_career_statistics(const rapidjson::Value& value) noexcept {
+    constexpr auto ratio_bucket_count = static_cast<std::size_t>(career_statistics::ratio_bucket_count);
+
+    return career_statistics(
+      value["game_count"].GetInt(),
+      read_int_array<7>(value["opening_face_counts"]),
+      read_int_array<ratio_bucket_count>(value["opening_ratio_counts"]),
+      read_int_array<ratio_bucket_count>(value["decision_counts"]),
+      read_int_array<ratio_bucket_count>(value["challenge_counts"]),
+      value["bid_count"].GetInt(),
+      value["bluff_count"].GetInt(),
+      value["raise_count"].GetInt(),
+      value["total_raise_size"].GetInt());
+  }
+
+  inline auto read_career_summaries(const rapidjson::Value& value) noexcept {
+    auto result = std::vector<career_summary>();
+
+    for (auto it = value.Begin(); it != value.End(); ++it) {
+      result.emplace_back(career_summary{(*it)["id"].GetString(), read_career_statistics((*it)["statistics"])});
+    }
+
+    return result;
+  }
+}
@@ -0,0 +1,123 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <rapidjson/document.h>
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "json.hpp"
+#include "rules.hpp"
+
+namespace liars_dice {
+  // プログラムの評価。スコアの合計とセット数を持つので、シャード毎の評価を足し合わせられます。
+  class program_evaluation final {
+    float _total_score;
+    int _set_count;
+
+  public:
+    program_evaluation(float total_score, int set_count) noexcept: _total_score(total_score), _set_count(set_count) {
+      ;
+    }
+
+    program_evaluation() noexcept: program_evaluation(0.0f, 0) {
+      ;
+    }
+
+    const auto& total_score() const noexcept {
+      return _total_score;
+    }
+
+    const auto& set_count() const noexcept {
+      return _set_count;
+    }
+
+    auto value() const noexcept {
+      return _set_count > 0 ? _total_score / _set_count : 0.0f;
+    }
+
+    auto add_score(float score) noexcept {
+      _total_score += score;
+
+      _set_count++;
+    }
+
+    auto merge(const program_evaluation& other) noexcept {
+      _total_score += other._total_score;
+      _set_count   += other._set_count;
+    }
+  };
+
+  // 選手権、もしくはそのシャードの結果。シャードiは、全セットのうちでi番目からshard_count個おきのセットを実行します。
+  struct championship_result final {
+    std::uint64_t seed;
+    int shard_index;
+    int shard_count;
+    int min_set_count;
+    liars_dice::rules rules;
+    bool is_duplicate;  // 重複（duplicate）モードのスコアは通常のモードのスコアとは意味が違うので、混ぜないように記録しておきます。
+    std::vector<std::tuple<std::string, program_evaluation>> program_evaluations;
+  };
+
+  // object -> json
+
+  inline auto write_championship_result(const championship_result& championship_result, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartObject();
+    writer.Key("seed");
+    writer.Uint64(championship_result.seed);
+    writer.Key("shard_index");
+    writer.Int(championship_result.shard_index);
+    writer.Key("shard_count");
+    writer.Int(championship_result.shard_count);
+    writer.Key("min_set_count");
+    writer.Int(championship_result.min_set_count);
+    writer.Key("rules");
+    write_rules(championship_result.rules, writer);
+    if (championship_result.is_duplicate) {
+      writer.Key("duplicate");
+      writer.Bool(true);
+    }
+    writer.Key("programs");
+    writer.StartArray();
+    for (const auto& [program_path, program_evaluation]: championship_result.program_evaluations) {
+      writer.StartObject();
+      writer.Key("path");
+      writer.String(program_path.c_str());
+      writer.Key("total_score");
+      writer.Double(program_evaluation.total_score());
+      writer.Key("set_count");
+      writer.Int(program_evaluation.set_count());
+      writer.EndObject();
+    }
+    writer.EndArray();
+    writer.EndObject();
+  }
+
+  // json -> object
+
+  inline auto read_championship_result(const rapidjson::Value& value) noexcept {
+    const auto& program_evaluations = [&]() {
+      auto result = std::vector<std::tuple<std::string, program_evaluation>>();
+
+      for (auto it = value["programs"].Begin(); it != value["programs"].End(); ++it) {
+        result.emplace_back((*it)["path"].GetString(), program_evaluation(static_cast<float>((*it)["total_score"].GetDouble()), (*it)["set_count"].GetInt()));
+      }
+
+      return result;
+    }();
+
+    const auto& rules = value.HasMember("rules") ? read_rules(value["rules"]) : liars_dice::rules();
+
+    const auto& is_duplicate = value.HasMember("duplicate") && value["duplicate"].GetBool();
+
+    return championship_result{value["seed"].GetUint64(), value["shard_index"].GetInt(), value["shard_count"].GetInt(), value["min_set_count"].GetInt(), rules, is_duplicate, program_evaluations};
+  }
+}
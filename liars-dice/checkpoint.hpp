@@ -0,0 +1,188 @@
+﻿#pragma once
+
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/filesystem.hpp>
+#include <rapidjson/document.h>
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "championship_result.hpp"
+#include "game.hpp"
+#include "json.hpp"
+#include "rating.hpp"
+
+namespace liars_dice {
+  // 選手権の途中経過。セットの組み合わせとダイスの目は種から決まるので、次に実行するセットの番号さえあれば、乱数の状態は不要です。
+  // 戦歴はpast_gamesから作成するので、past_gamesも保存します（all-games.jsonの出力にも必要ですし）。ただし、毎回全てを書き直すと長い選手権では2乗で重くなるので、
+  // past_gamesは別のファイル（checkpoint_games_path_string）に1行に1ゲームずつ追記して、途中経過のJSONにはゲームの数だけを書きます。
+  struct championship_checkpoint final {
+    championship_result result;
+    int next_set_index;
+    std::vector<std::tuple<std::unordered_map<std::string, std::string>, game>> past_games;
+    std::vector<std::tuple<std::string, rating>> program_ratings;
+    std::optional<double> stop_confidence;  // 再開した時にも同じ条件で終了するように、保存しておきます。
+  };
+
+  // object -> json
+
+  inline auto write_championship_checkpoint(const championship_checkpoint& championship_checkpoint, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartObject();
+    writer.Key("result");
+    write_championship_result(championship_checkpoint.result, writer);
+    writer.Key("next_set_index");
+    writer.Int(championship_checkpoint.next_set_index);
+    writer.Key("past_game_count");
+    writer.Uint64(std::size(championship_checkpoint.past_games));
+    writer.Key("ratings");
+    write_program_ratings(championship_checkpoint.program_ratings, writer);
+    if (championship_checkpoint.stop_confidence) {
+      writer.Key("stop_confidence");
+      writer.Double(championship_checkpoint.stop_confidence.value());
+    }
+    writer.EndObject();
+  }
+
+  // json -> object
+
+  // past_gamesは、古い形式（JSONにpast_gamesがある）の場合だけ読みます。新しい形式では、read_championship_checkpoint_fileが別のファイルから読みます。
+  inline auto read_championship_checkpoint(const rapidjson::Value& value) noexcept {
+    return championship_checkpoint{read_championship_result(value["result"]), value["next_set_index"].GetInt(), value.HasMember("past_games") ? read_past_games(value["past_games"]) : std::vector<std::tuple<std::unordered_map<std::string, std::string>, game>>(), read_program_ratings(value["ratings"]), value.HasMember("stop_confidence") ? std::optional(value["stop_confidence"].GetDouble()) : std::nullopt};
+  }
+
+  // file
+
+  inline auto checkpoint_games_path_string(const std::string& path_string) noexcept {
+    return path_string + ".games";
+  }
+
+  // written_past_game_countは、このプロセスで既にファイルに追記したゲームの数です。0の場合（起動や再開の直後、追記に失敗した後）は全てのゲームを一時ファイルに書いてからリネームして、それ以外の場合は増えた分だけを追記します。
+  // 前回の途中経過のJSONが参照しているゲームの行は、どちらの場合も書き換えません。ゲームのファイルに余分な行が残っても、JSONのゲームの数までしか読まないので大丈夫です。
+  // ゲームを書き終えてから、書き込み途中で止まっても前回の途中経過が壊れないように、JSONを一時ファイルに書いてからリネームします。
+  // noexceptのplay_championshipから呼ばれるので、失敗しても例外にはせずに報告だけします。追記したゲームの数を返すので、次回のwritten_past_game_countにしてください。
+  inline auto write_championship_checkpoint_file(const std::string& path_string, const championship_checkpoint& championship_checkpoint, std::size_t written_past_game_count) noexcept {
+    const auto& report = [&](const auto& message) {
+      std::cerr << "*** CANNOT WRITE CHECKPOINT to " << path_string << ": " << message << " ***" << std::endl;
+    };
+
+    const auto& write_file = [&](const std::string& file_path_string, std::ios::openmode openmode, const auto& write) {
+      auto ofstream = std::ofstream(file_path_string, openmode);
+      write(ofstream);
+      ofstream.close();
+
+      return static_cast<bool>(ofstream);
+    };
+
+    const auto& rename_file = [&](const std::string& temporary_path_string, const std::string& file_path_string) {
+      auto error_code = boost::system::error_code();
+
+      boost::filesystem::rename(temporary_path_string, file_path_string, error_code);
+
+      if (error_code) {
+        report(error_code.message());
+      }
+
+      return !error_code;
+    };
+
+    const auto& write_past_games = [&](std::ostream& ostream) {
+      for (auto i = written_past_game_count; i < std::size(championship_checkpoint.past_games); ++i) {
+        write_json(ostream, championship_checkpoint.past_games[i], std::function(write_past_game)); ostream << '\n';
+      }
+    };
+
+    const auto& games_path_string = checkpoint_games_path_string(path_string);
+
+    if (written_past_game_count == 0) {
+      if (!write_file(games_path_string + ".tmp", std::ios::out | std::ios::trunc, write_past_games)) {
+        report("cannot write " + games_path_string + ".tmp");
+
+        return static_cast<std::size_t>(0);
+      }
+
+      if (!rename_file(games_path_string + ".tmp", games_path_string)) {
+        return static_cast<std::size_t>(0);
+      }
+    } else {
+      if (!write_file(games_path_string, std::ios::out | std::ios::app, write_past_games)) {
+        report("cannot write " + games_path_string);
+
+        return static_cast<std::size_t>(0);  // 途中まで書いたかもしれないので、次回は作り直します。
+      }
+    }
+
+    if (!write_file(path_string + ".tmp", std::ios::out | std::ios::trunc, [&](auto& ostream) { write_json(ostream, championship_checkpoint, std::function(write_championship_checkpoint)); })) {
+      report("cannot write " + path_string + ".tmp");  // 前回の途中経過は残します。
+
+      return std::size(championship_checkpoint.past_games);
+    }
+
+    rename_file(path_string + ".tmp", path_string);
+
+    return std::size(championship_checkpoint.past_games);
+  }
+
+  // 壊れている場合は、どのファイルが壊れているのかをメッセージにして、std::runtime_errorを投げます。JSONとして読めない場合は、rapidjsonの値はnullになります。
+  inline auto read_championship_checkpoint_file(const std::string& path_string) {
+    auto ifstream = std::ifstream(path_string);
+    auto stream = std::stringstream(); stream << ifstream.rdbuf();
+
+    auto result          = std::optional<championship_checkpoint>();
+    auto past_game_count = std::optional<std::size_t>();
+
+    parse_json(stream.str(), [&](const auto& value) {
+      if (!value.IsObject() || !value.HasMember("result") || !value.HasMember("next_set_index") || !value.HasMember("ratings")) {
+        return;
+      }
+
+      result.emplace(read_championship_checkpoint(value));
+
+      if (value.HasMember("past_game_count")) {
+        past_game_count = static_cast<std::size_t>(value["past_game_count"].GetUint64());
+      }
+    });
+
+    if (!result) {
+      throw std::runtime_error("corrupt " + path_string);
+    }
+
+    if (past_game_count) {
+      const auto& games_path_string = checkpoint_games_path_string(path_string);
+
+      auto games_ifstream = std::ifstream(games_path_string);
+
+      for (auto line = std::string(); std::size(result->past_games) < past_game_count.value() && std::getline(games_ifstream, line); ) {
+        const auto& line_number = std::size(result->past_games) + 1;
+
+        parse_json(line, [&](const auto& value) {
+          if (value.IsObject()) {
+            result->past_games.emplace_back(read_past_game(value));
+          }
+        });
+
+        if (std::size(result->past_games) < line_number) {
+          throw std::runtime_error("corrupt line " + std::to_string(line_number) + " in " + games_path_string);
+        }
+      }
+
+      if (std::size(result->past_games) < past_game_count.value()) {
+        throw std::runtime_error("missing games in " + games_path_string);
+      }
+    }
+
+    return std::move(result.value());
+  }
+}
@@ -0,0 +1,310 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define LIARS_DICE_CLASSIFIER_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/range/adaptors.hpp>
+#include <boost/range/numeric.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "features.hpp"
+#include "game.hpp"
+#include "json.hpp"
+
+namespace liars_dice {
+  // doc/check-other-programs.mdのプレイヤー判別のニューラル・ネットワーク（全結合層とReLUを重ねて、最後をsoftmaxにしたもの）の推論。
+  // Pythonを組み込まなくても、学習済みの重みをファイルから読み込めば、プログラムの中で判別できます。
+  //
+  // 重みのファイルの形式（数値は全てリトル・エンディアン）:
+  //   "LDDENSE"、バージョン（1バイト）、層の数（4バイト）、
+  //   層毎に{入力の数（4バイト）、出力の数（4バイト）、重み（float32で入力の数 * 出力の数。KerasのDenseのkernelと同じ並び）、バイアス（float32で出力の数）}
+  //
+  // Kerasからは、こんな感じで出力できます。
+  //   f.write(b'LDDENSE\x01' + np.uint32(len(denses)).tobytes())
+  //   for dense in denses: w, b = dense.get_weights(); f.write(np.uint32(w.shape).tobytes() + w.astype('<f4').tobytes() + b.astype('<f4').tobytes())
+
+  constexpr auto classifier_magic   = "LDDENSE";
+  constexpr auto classifier_version = 1;
+
+  // SIMDで処理しやすいように、入力と出力の数を16の倍数に、行の数を4の倍数に切り上げて処理します。切り上げた部分の重みとバイアスは0です。
+  constexpr auto classifier_column_alignment = 16;
+  constexpr auto classifier_row_alignment    = 4;
+  constexpr auto classifier_batch_size       = 32;
+
+  using program_class_probabilities = std::array<float, program_class_count>;
+
+  inline auto aligned_size(int size, int alignment) noexcept {
+    return (size + alignment - 1) / alignment * alignment;
+  }
+
+  class dense_layer final {
+    int _input_size;
+    int _output_size;
+    std::vector<float> _weights;  // aligned_size(input_size) * aligned_size(output_size)
+    std::vector<float> _biases;   // aligned_size(output_size)
+
+  public:
+    dense_layer(int input_size, int output_size, const std::vector<float>& weights, const std::vector<float>& biases) noexcept: _input_size(input_size), _output_size(output_size), _weights(aligned_size(input_size, classifier_column_alignment) * aligned_size(output_size, classifier_column_alignment), 0), _biases(aligned_size(output_size, classifier_column_alignment), 0) {
+      for (auto i = 0; i < input_size; ++i) {
+        std::copy(std::begin(weights) + i * output_size, std::begin(weights) + (i + 1) * output_size, std::begin(_weights) + i * aligned_size(output_size, classifier_column_alignment));
+      }
+
+      std::copy(std::begin(biases), std::end(biases), std::begin(_biases));
+    }
+
+    auto input_size() const noexcept {
+      return _input_size;
+    }
+
+    auto output_size() const noexcept {
+      return _output_size;
+    }
+
+    auto padded_input_size() const noexcept {
+      return aligned_size(_input_size, classifier_column_alignment);
+    }
+
+    auto padded_output_size() const noexcept {
+      return aligned_size(_output_size, classifier_column_alignment);
+    }
+
+    // xsはrow_count * padded_input_size()、ysはrow_count * padded_output_size()の、行優先の配列です。row_countは4の倍数にしてください。
+    auto forward(const float* xs, float* ys, int row_count, bool is_relu) const noexcept {
+      const auto& input_size  = padded_input_size();
+      const auto& output_size = padded_output_size();
+
+      #ifdef LIARS_DICE_CLASSIFIER_AVX2
+      // 4行 * 16列の出力をレジスターに置いたまま、入力の方向に積和します。16列分の重みがキャッシュに載っている間に全ての行を処理するように、列を外側のループにしました。
+      for (auto j = 0; j < output_size; j += 16) {
+        for (auto i = 0; i < row_count; i += 4) {
+          auto y00 = _mm256_loadu_ps(&_biases[j]); auto y01 = _mm256_loadu_ps(&_biases[j + 8]);
+          auto y10 = y00;                          auto y11 = y01;
+          auto y20 = y00;                          auto y21 = y01;
+          auto y30 = y00;                          auto y31 = y01;
+
+          for (auto k = 0; k < input_size; ++k) {
+            const auto& w0 = _mm256_loadu_ps(&_weights[k * output_size + j]);
+            const auto& w1 = _mm256_loadu_ps(&_weights[k * output_size + j + 8]);
+
+            const auto& x0 = _mm256_broadcast_ss(&xs[(i + 0) * input_size + k]);
+            const auto& x1 = _mm256_broadcast_ss(&xs[(i + 1) * input_size + k]);
+            const auto& x2 = _mm256_broadcast_ss(&xs[(i + 2) * input_size + k]);
+            const auto& x3 = _mm256_broadcast_ss(&xs[(i + 3) * input_size + k]);
+
+            y00 = _mm256_fmadd_ps(x0, w0, y00); y01 = _mm256_fmadd_ps(x0, w1, y01);
+            y10 = _mm256_fmadd_ps(x1, w0, y10); y11 = _mm256_fmadd_ps(x1, w1, y11);
+            y20 = _mm256_fmadd_ps(x2, w0, y20); y21 = _mm256_fmadd_ps(x2, w1, y21);
+            y30 = _mm256_fmadd_ps(x3, w0, y30); y31 = _mm256_fmadd_ps(x3, w1, y31);
+          }
+
+          if (is_relu) {
+            const auto& zero = _mm256_setzero_ps();
+
+            y00 = _mm256_max_ps(y00, zero); y01 = _mm256_max_ps(y01, zero);
+            y10 = _mm256_max_ps(y10, zero); y11 = _mm256_max_ps(y11, zero);
+            y20 = _mm256_max_ps(y20, zero); y21 = _mm256_max_ps(y21, zero);
+            y30 = _mm256_max_ps(y30, zero); y31 = _mm256_max_ps(y31, zero);
+          }
+
+          _mm256_storeu_ps(&ys[(i + 0) * output_size + j], y00); _mm256_storeu_ps(&ys[(i + 0) * output_size + j + 8], y01);
+          _mm256_storeu_ps(&ys[(i + 1) * output_size + j], y10); _mm256_storeu_ps(&ys[(i + 1) * output_size + j + 8], y11);
+          _mm256_storeu_ps(&ys[(i + 2) * output_size + j], y20); _mm256_storeu_ps(&ys[(i + 2) * output_size + j + 8], y21);
+          _mm256_storeu_ps(&ys[(i + 3) * output_size + j], y30); _mm256_storeu_ps(&ys[(i + 3) * output_size + j + 8], y31);
+        }
+      }
+      #else
+      // AVX2とFMAが使えない環境向けの、同じ計算をする素直な実装です。
+      for (auto i = 0; i < row_count; ++i) {
+        auto* y = &ys[i * output_size];
+
+        std::copy(std::begin(_biases), std::end(_biases), y);
+
+        for (auto k = 0; k < input_size; ++k) {
+          const auto& x = xs[i * input_size + k];
+          const auto* w = &_weights[k * output_size];
+
+          for (auto j = 0; j < output_size; ++j) {
+            y[j] += x * w[j];
+          }
+        }
+
+        if (is_relu) {
+          for (auto j = 0; j < output_size; ++j) {
+            y[j] = std::max(y[j], 0.0f);
+          }
+        }
+      }
+      #endif
+    }
+  };
+
+  class classifier final {
+    std::vector<dense_layer> _layers;
+
+  public:
+    classifier(const std::vector<dense_layer>& layers): _layers(layers) {
+      if (std::empty(_layers) || _layers.front().input_size() != window_feature_size || _layers.back().output_size() != program_class_count) {
+        throw std::runtime_error("classifier must map " + std::to_string(window_feature_size) + " features to " + std::to_string(program_class_count) + " classes");
+      }
+
+      for (auto i = 1; i < static_cast<int>(std::size(_layers)); ++i) {
+        if (_layers[i].input_size() != _layers[i - 1].output_size()) {
+          throw std::runtime_error("classifier layer " + std::to_string(i) + " does not match the previous layer");
+        }
+      }
+    }
+
+    const auto& layers() const noexcept {
+      return _layers;
+    }
+
+    // 複数の入力を、まとめて判別します。中間の値がキャッシュに収まるように、32行ずつ処理します。
+    auto predict(const std::vector<window_features>& xs) const noexcept {
+      auto result = std::vector<program_class_probabilities>(); result.reserve(std::size(xs));
+
+      const auto& max_column_count = boost::accumulate(_layers | boost::adaptors::transformed([](const auto& layer) { return layer.padded_output_size(); }), _layers.front().padded_input_size(), [](const auto& acc, const auto& size) { return std::max(acc, size); });
+
+      auto inputs  = std::vector<float>(classifier_batch_size * max_column_count);
+      auto outputs = std::vector<float>(classifier_batch_size * max_column_count);
+
+      for (auto i = 0; i < static_cast<int>(std::size(xs)); i += classifier_batch_size) {
+        const auto& row_count         = static_cast<int>(std::min(classifier_batch_size, static_cast<int>(std::size(xs)) - i));
+        const auto& aligned_row_count = aligned_size(row_count, classifier_row_alignment);
+
+        std::fill(std::begin(inputs), std::begin(inputs) + aligned_row_count * _layers.front().padded_input_size(), 0.0f);
+
+        for (auto j = 0; j < row_count; ++j) {
+          std::copy(std::begin(xs[i + j]), std::end(xs[i + j]), std::begin(inputs) + j * _layers.front().padded_input_size());
+        }
+
+        for (auto j = 0; j < static_cast<int>(std::size(_layers)); ++j) {
+          _layers[j].forward(std::data(inputs), std::data(outputs), aligned_row_count, j < static_cast<int>(std::size(_layers)) - 1);
+
+          std::swap(inputs, outputs);
+        }
+
+        // 最後の層はsoftmaxします。
+        for (auto j = 0; j < row_count; ++j) {
+          const auto* ys = &inputs[j * _layers.back().padded_output_size()];
+
+          const auto& max_y = *std::max_element(ys, ys + program_class_count);
+
+          auto probabilities = program_class_probabilities();
+
+          for (auto k = 0; k < program_class_count; ++k) {
+            probabilities[k] = std::exp(ys[k] - max_y);
+          }
+
+          const auto& sum = boost::accumulate(probabilities, 0.0f);
+
+          for (auto& probability: probabilities) {
+            probability /= sum;
+          }
+
+          result.emplace_back(probabilities);
+        }
+      }
+
+      return result;
+    }
+  };
+
+  // file
+
+  inline auto read_classifier_file(const std::string& path_string) {
+    auto ifstream = std::ifstream(path_string, std::ios::binary);
+
+    const auto& read_uint32 = [&]() {
+      auto result = static_cast<std::uint32_t>(0); ifstream.read(reinterpret_cast<char*>(&result), 4);  // リトル・エンディアンの環境を前提にしています。
+
+      return static_cast<int>(result);
+    };
+
+    const auto& read_floats = [&](int count) {
+      auto result = std::vector<float>(count); ifstream.read(reinterpret_cast<char*>(std::data(result)), static_cast<std::streamsize>(count) * 4);
+
+      return result;
+    };
+
+    auto magic = std::string(8, '\0');
+
+    if (!ifstream.read(std::data(magic), 8) || magic.compare(0, 7, classifier_magic) != 0 || magic[7] != classifier_version) {
+      throw std::runtime_error("not a classifier: " + path_string);
+    }
+
+    auto layers = std::vector<dense_layer>();
+
+    for (auto i = read_uint32(), j = 0; j < i; ++j) {
+      const auto& input_size  = read_uint32();
+      const auto& output_size = read_uint32();
+      const auto& weights     = read_floats(input_size * output_size);
+      const auto& biases      = read_floats(output_size);
+
+      if (!ifstream) {
+        throw std::runtime_error("truncated classifier: " + path_string);
+      }
+
+      layers.emplace_back(input_size, output_size, weights, biases);
+    }
+
+    return classifier(layers);
+  }
+
+  // check_other_programsで受け取った戦歴の全てを、まとめて判別します。戦歴の中の5手ずつの判別結果の平均を、そのプログラムの判別結果とします。
+  // 5手に満たないプログラムの判別結果は、全てのクラスが同じ確率になります。
+  inline auto classify_careers(const classifier& classifier, const std::vector<career>& careers) {
+    auto xs      = std::vector<window_features>();
+    auto offsets = std::vector<int>{0};
+
+    for (const auto& career: careers) {
+      auto move_features_collection = std::vector<move_features>();
+
+      // 戦歴は新しい順に並んでいるので、古い順にします。
+      for (const auto& career_record: career.career_records | boost::adaptors::reversed) {
+        const auto& player_move_features = get_player_move_features(career_record.game, career_record.id);
+
+        move_features_collection.insert(std::end(move_features_collection), std::begin(player_move_features), std::end(player_move_features));
+      }
+
+      const auto& window_features_collection = get_window_features(move_features_collection);
+
+      xs.insert(std::end(xs), std::begin(window_features_collection), std::end(window_features_collection));
+      offsets.emplace_back(static_cast<int>(std::size(xs)));
+    }
+
+    const auto& ys = classifier.predict(xs);
+
+    auto result = std::vector<std::tuple<std::string, program_class_probabilities>>(); result.reserve(std::size(careers));
+
+    for (auto i = 0; i < static_cast<int>(std::size(careers)); ++i) {
+      auto probabilities = program_class_probabilities(); probabilities.fill(offsets[i + 1] > offsets[i] ? 0.0f : 1.0f / program_class_count);
+
+      for (auto j = offsets[i]; j < offsets[i + 1]; ++j) {
+        for (auto k = 0; k < program_class_count; ++k) {
+          probabilities[k] += ys[j][k] / (offsets[i + 1] - offsets[i]);
+        }
+      }
+
+      result.emplace_back(careers[i].id, probabilities);
+    }
+
+    return result;
+  }
+}
@@ -0,0 +1,37 @@
+﻿#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/filesystem.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "../game_log.hpp"
+
+// all-games.jsonとバイナリ形式のゲーム・ログを相互に変換します。入力の形式は中身で、出力の形式は拡張子（.binならバイナリ）で判断します。
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "usage: liars-dice-convert input-games-path output-games-path" << std::endl;
+    std::exit(1);
+  }
+
+  const auto& starting_time = std::chrono::steady_clock::now();
+
+  const auto& past_games = liars_dice::read_past_games_file(argv[1]);
+
+  const auto& read_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - starting_time).count();
+
+  liars_dice::write_past_games_file(argv[2], past_games);
+
+  std::cout << "games\t" << std::size(past_games) << std::endl;
+  std::cout << "input\t" << boost::filesystem::file_size(argv[1]) << " bytes\t" << std::fixed << std::setprecision(3) << read_seconds << " sec to read" << std::defaultfloat << std::endl;
+  std::cout << "output\t" << boost::filesystem::file_size(argv[2]) << " bytes" << std::endl;
+
+  return 0;
+}
@@ -1,16 +1,23 @@
 ﻿#pragma once
 
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <optional>
 #include <random>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #ifdef _MSC_VER
 #pragma warning(push, 0)
 #endif
 #include <boost/algorithm/cxx11/any_of.hpp>
+#include <boost/algorithm/string/trim.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/process.hpp>
 #include <boost/range/adaptors.hpp>
@@ -21,11 +28,40 @@
 #pragma warning(pop)
 #endif
 
+#include "career_map.hpp"
+#include "career_summary.hpp"
+#include "championship_result.hpp"
+#include "checkpoint.hpp"
 #include "game.hpp"
+#include "game_log.hpp"
+#include "metrics.hpp"
 #include "program_proxy.hpp"
+#include "rating.hpp"
+#include "rules.hpp"
+#include "statistics.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 
 namespace liars_dice {
+  // 選手権のオプション。
+  struct championship_options final {
+    int min_set_count = 0;
+    liars_dice::rules rules;                                   // テーブルの人数やダイスの数。
+    std::optional<std::string> statistics_path_string;         // 通信の統計情報を出力するファイル。
+    std::optional<std::string> metrics_path_string;            // 実行中の計測値を定期的に出力するファイル。
+    std::uint64_t seed = 0;                                    // 乱数の種。セットの組み合わせとダイスの目は、この種から決まります。
+    int shard_index = 0;                                       // 複数のプロセスで手分けする場合の、自分の番号。
+    int shard_count = 1;                                       // 複数のプロセスで手分けする場合の、プロセスの数。
+    std::string games_path_string = "all-games.json";          // 全ての試合を記録するファイル。拡張子が.binならバイナリ形式になります。
+    std::optional<std::string> result_path_string;             // 結果を出力するファイル。liars-dice-mergeでシャードの結果をまとめる際に使用します。
+    std::optional<std::string> checkpoint_path_string;         // 途中経過を定期的に出力するファイル。
+    std::optional<championship_checkpoint> resumed_checkpoint; // 再開する場合の、前回の途中経過。
+    std::optional<double> stop_confidence;                     // 指定した場合は、レーティングの順位がこの確率で確定した時点で終了します。min_set_countは上限になります。
+    bool is_duplicate = false;                                 // 同じダイスの目と席順で、プログラムの席を入れ替えながらセットを繰り返します。
+    bool sends_career_summaries = false;                       // 生の戦歴に加えて、戦歴の集計値もcheck_career_summariesで通知します。capabilitiesにcheck_career_summariesと書いたプログラムだけが対象です。
+    std::optional<std::string> career_map_path_string;         // 指定した場合は、戦歴をセット毎にこのファイルに書いて、check_other_program_mapでパスだけを通知します。capabilitiesにcheck_other_program_mapと書いたプログラムだけが対象です。
+  };
+
   inline auto program_path_nickname(const std::string& program_path_string) noexcept {
     const auto& path  = boost::filesystem::path(program_path_string);
     const auto& paths = std::vector<boost::filesystem::path>(std::begin(path), std::end(path));
@@ -33,6 +69,35 @@ namespace liars_dice {
     return paths[std::size(paths) - 2].string().substr(0, 7);
   }
 
+  // プログラムが対応している、追加のコマンド。runと同じディレクトリのcapabilitiesというファイルに、1行に1つずつコマンド名を書きます。
+  // 古いプログラムは知らないコマンドに応答しなくてタイムアウトしてしまうので、ファイルに書かれていないコマンドは送りません。
+  inline auto program_capabilities(const std::string& program_path_string) noexcept {
+    auto result = std::unordered_set<std::string>();
+
+    auto ifstream = std::ifstream((boost::filesystem::path(program_path_string).parent_path() / "capabilities").string());
+
+    for (auto line = std::string(); std::getline(ifstream, line); ) {
+      boost::algorithm::trim(line);  // Windowsで作成したファイルの改行対策。
+
+      if (!std::empty(line)) {
+        result.emplace(line);
+      }
+    }
+
+    return result;
+  }
+
+  // セット内でのプログラムのID。A、B、……、Z、AA、AB、……のように、表計算ソフトの列名と同じ形式にします。
+  inline auto program_id(int index) noexcept {
+    auto result = std::string();
+
+    for (auto i = index + 1; i > 0; i = (i - 1) / 26) {
+      result.insert(std::begin(result), static_cast<char>('A' + (i - 1) % 26));
+    }
+
+    return result;
+  }
+
   inline auto show_game(const std::vector<std::string>& program_path_strings, const game& game, const std::vector<int>& dice_count_deltas) noexcept {
     std::cout << "# Dices" << std::endl;
     std::cout << std::endl;
@@ -104,6 +169,22 @@ namespace liars_dice {
     std::cout << std::endl;
   }
 
+  // レーティングを、平均と標準偏差、95%信頼区間で表示します。
+  inline auto show_ratings(const std::vector<std::string>& program_path_strings, const std::vector<rating>& ratings) noexcept {
+    std::cout << "# Ratings" << std::endl;
+    std::cout << std::endl;
+
+    auto program_path_and_ratings = boost::copy_range<std::vector<std::tuple<std::string, rating>>>(util::combine(program_path_strings, ratings));
+
+    boost::sort(program_path_and_ratings, [](const auto& program_path_and_rating_1, const auto& program_path_and_rating_2) { return std::get<1>(program_path_and_rating_1).mu() > std::get<1>(program_path_and_rating_2).mu(); });
+
+    for (const auto& [program_path_string, rating]: program_path_and_ratings) {
+      std::cout << program_path_nickname(program_path_string) << "\t" << std::fixed << std::setprecision(3) << rating.mu() << "\t" << rating.sigma() << "\t" << rating.mu() - 1.96 * rating.sigma() << "\t" << rating.mu() + 1.96 * rating.sigma() << std::defaultfloat << std::endl;
+    }
+
+    std::cout << std::endl;
+  }
+
   inline auto show_logs(const std::vector<std::string>& program_path_strings, const std::vector<std::string>& log_strings) noexcept {
     std::cout << "# Logs" << std::endl;
     std::cout << std::endl;
@@ -119,11 +200,113 @@ namespace liars_dice {
     std::cout << std::endl;
   }
 
-  inline auto play_championship(const std::vector<std::string>& program_path_strings, int min_set_count) noexcept {
+  inline auto show_resource_usages(const std::vector<std::string>& program_path_strings, const std::vector<std::shared_ptr<program_proxy>>& program_proxies) noexcept {
+    std::cout << "# Resource Usages" << std::endl;
+    std::cout << std::endl;
+
+    const auto& show_resource_usage = [](const auto& program_path_string, const auto& name, const auto& resource_usage) {
+      std::cout << program_path_nickname(program_path_string) << "\t" << name << "\t" << std::fixed << std::setprecision(3) << resource_usage.user_seconds << "s user\t" << resource_usage.system_seconds << "s system\t" << std::defaultfloat << resource_usage.voluntary_context_switch_count << "/" << resource_usage.involuntary_context_switch_count << " context switches";
+    };
+
+    for (const auto& [program_path_string, program_proxy]: util::combine(program_path_strings, program_proxies)) {
+      for (const auto& [command, resource_usage]: program_proxy->command_resource_usages()) {
+        show_resource_usage(program_path_string, command, resource_usage);
+        std::cout << std::endl;
+      }
+
+      show_resource_usage(program_path_string, "total", program_proxy->total_resource_usage());
+      std::cout << "\t" << program_proxy->total_resource_usage().peak_resident_set_size / 1024 << "KB peak RSS" << std::endl;
+    }
+
+    std::cout << std::endl;
+  }
+
+  inline auto show_communication_statistics(const std::vector<std::string>& program_path_strings, const std::vector<communication_statistics>& communication_statistics) noexcept {
+    std::cout << "# Communication Statistics" << std::endl;
+    std::cout << std::endl;
+
+    for (const auto& [program_path_string, communication_statistics_]: util::combine(program_path_strings, communication_statistics)) {
+      for (const auto& [command, latency_histogram]: communication_statistics_.latency_histograms()) {
+        std::cout << program_path_nickname(program_path_string) << "\t" << command << "\t" << latency_histogram.count() << "\t" << std::fixed << std::setprecision(3) << latency_histogram.percentile(50) / 1000.0 << "\t" << latency_histogram.percentile(99) / 1000.0 << "\t" << latency_histogram.max() / 1000.0 << "\t" << latency_histogram.total() / 1000.0 << std::defaultfloat << std::endl;
+      }
+
+      std::cout << program_path_nickname(program_path_string) << "\t" << communication_statistics_.sent_byte_count() << " bytes sent, " << communication_statistics_.received_byte_count() << " bytes received, " << communication_statistics_.timeout_count() << " timeouts, " << communication_statistics_.communication_error_count() << " communication errors." << std::endl;
+    }
+
+    std::cout << std::endl;
+  }
+
+  // 全てのプログラムがmin_set_count回以上のセットを実行するまでの、セットの組み合わせと席順を作成します。
+  // 実行前に全部決めてしまうので、どのセットをどのシャードで実行しても、同じ種からは同じ組み合わせになります。
+  // セット数が少ないプログラムから順に選ぶので、ほぼ最小のセット数（プログラム数 * min_set_count / table_size）で全員が目標に達します。
+  // セット数が同じ場合は、既に選んだプログラムと同じセットになった回数が少ないプログラムを選んで、対戦相手の偏りを減らします。
+  inline auto schedule_sets(const std::vector<std::string>& program_paths, int min_set_count, int table_size, std::uint64_t seed) noexcept {
+    auto result = std::vector<std::vector<std::string>>();
+
+    auto random_engine = util::portable_random_engine(util::mix_seed(seed, 0));
+
+    const auto& program_count = static_cast<int>(std::size(program_paths));
+
+    auto set_counts  = std::vector<int>(program_count, 0);
+    auto pair_counts = std::vector<std::vector<int>>(program_count, std::vector<int>(program_count, 0));
+
+    while (boost::algorithm::any_of(set_counts, [&](const auto& set_count) { return set_count < min_set_count; })) {
+      auto indices = std::vector<int>();
+
+      while (static_cast<int>(std::size(indices)) < std::min(program_count, table_size)) {
+        auto candidates = boost::copy_range<std::vector<int>>(
+          boost::irange(0, program_count) |
+          boost::adaptors::filtered([&](const auto& index) { return std::find(std::begin(indices), std::end(indices), index) == std::end(indices); }));
+
+        // 条件が同じ場合はランダムに選びたいので、シャッフルしてから最初の最小値を選びます。
+        util::shuffle(candidates, random_engine);
+
+        const auto& key = [&](const auto& index) {
+          return std::make_tuple(set_counts[index], boost::accumulate(indices | boost::adaptors::transformed([&](const auto& other_index) { return pair_counts[index][other_index]; }), 0));
+        };
+
+        indices.emplace_back(*boost::min_element(candidates, [&](const auto& index_1, const auto& index_2) { return key(index_1) < key(index_2); }));
+      }
+
+      for (const auto& index: indices) {
+        set_counts[index]++;
+
+        for (const auto& other_index: indices) {
+          if (other_index != index) {
+            pair_counts[index][other_index]++;
+          }
+        }
+      }
+
+      // セット内の席順（IDの割り当て）もランダムにします。ゲーム毎の席順は、play_setでシャッフルされます。
+      util::shuffle(indices, random_engine);
+
+      result.emplace_back(boost::copy_range<std::vector<std::string>>(indices | boost::adaptors::transformed([&](const auto& index) { return program_paths[index]; })));
+    }
+
+    return result;
+  }
+
+  inline auto play_championship(const std::vector<std::string>& program_path_strings, const championship_options& options) noexcept {
     using program_path_t = std::string;
     using program_id_t   = std::string;
 
-    auto past_games = std::vector<std::tuple<std::unordered_map<program_path_t, program_id_t>, game>>();
+    const auto& min_set_count = options.min_set_count;
+
+    std::cout << "# Seed" << std::endl;
+    std::cout << std::endl;
+    std::cout << options.seed << "\t" << options.shard_index << "/" << options.shard_count << std::endl;
+    std::cout << std::endl;
+
+    auto past_games = options.resumed_checkpoint ? options.resumed_checkpoint->past_games : std::vector<std::tuple<std::unordered_map<program_path_t, program_id_t>, game>>();
+
+    // プログラム毎の通信の統計情報。プロキシーはセット毎に作り直すので、セットの終了時に集計します。
+    auto program_communication_statistics = boost::copy_range<std::unordered_map<program_path_t, communication_statistics>>(
+      program_path_strings |
+      boost::adaptors::transformed([](const auto& program_path) { return std::make_pair(program_path, communication_statistics()); }));
+
+    // 実行中の計測値。10秒毎にファイルに出力します。シャードの場合は、シャード数で割ったセット数をざっくりとした目標にします。
+    auto metrics = championship_metrics(options.metrics_path_string, std::chrono::seconds(10), (min_set_count + options.shard_count - 1) / options.shard_count, program_path_strings);
 
     // 他のプログラムの性格診断向けのデータを作成する関数。
     const auto& careers = [&](const auto& program_paths, const auto& program_ids) {
@@ -148,31 +331,76 @@ namespace liars_dice {
       // 重たそうな処理だったので、敢えて手続き型で書いてみました。
     };
 
+    // プログラム毎の戦歴の集計値。ゲームの終了時に足し込んでいきます。再開した場合は、過去のゲーム集から作り直します。
+    auto program_career_statistics = boost::copy_range<std::unordered_map<program_path_t, career_statistics>>(
+      program_path_strings |
+      boost::adaptors::transformed([](const auto& program_path) { return std::make_pair(program_path, career_statistics()); }));
+
+    for (const auto& [program_path_and_program_ids, game]: past_games) {
+      for (const auto& [program_path, program_id]: program_path_and_program_ids) {
+        const auto& it = boost::find_if(game.players(), [&, program_id = program_id](const auto& player) { return player.id() == program_id; });  // P0588R1...
+
+        if (it != std::end(game.players()) && program_career_statistics.count(program_path)) {
+          program_career_statistics[program_path].add_game(game, static_cast<int>(it - std::begin(game.players())));
+        }
+      }
+    }
+
+    // プログラム毎の、対応している追加のコマンド。
+    const auto& program_capabilities_ = boost::copy_range<std::unordered_map<program_path_t, std::unordered_set<std::string>>>(
+      program_path_strings |
+      boost::adaptors::transformed([](const auto& program_path) { return std::make_pair(program_path, program_capabilities(program_path)); }));
+
+    // 戦歴のファイル。シャード毎に別のファイルにします。
+    const auto& career_map_path_string = [&]() -> std::optional<std::string> {
+      if (!options.career_map_path_string) {
+        return std::nullopt;
+      }
+
+      return boost::filesystem::absolute(options.career_map_path_string.value()).string() + (options.shard_count > 1 ? "." + std::to_string(options.shard_index) : "");
+    }();
+
+    // 戦歴のファイルの世代番号。セット毎に増やします。同じファイルを指定した別のディーラーの世代番号と重ならないように、種とシャードの番号から始めます。
+    auto career_map_generation = util::mix_seed(options.seed, options.shard_index);
+
     // 最後の一人になるまでゲームを繰り返す関数。
-    const auto& play_set = [&](const auto& program_paths) {
-      auto random_engine = std::mt19937_64(std::random_device()());
+    // set_seedの0番目の乱数は席順に、i + 1番目の乱数はi番目のゲームのダイスの目に使用します。
+    const auto& play_set = [&](const auto& program_paths, std::uint64_t set_seed) {
+      LIARS_DICE_TRACE_SCOPE("play_set");
+
+      auto random_engine = util::portable_random_engine(util::mix_seed(set_seed, 0));
+      auto game_index = static_cast<std::uint64_t>(0);
 
       // プログラム側からの追跡を困難にするために、セット毎にプログラムにIDを振り直します。
       const auto& program_ids = boost::copy_range<std::unordered_map<program_path_t, program_id_t>>(
         program_paths |
         boost::adaptors::indexed() |
-        boost::adaptors::transformed([](const auto& indexed_program_path) { return std::make_pair(indexed_program_path.value(), std::string(1, 'A' + indexed_program_path.index())); }));
+        boost::adaptors::transformed([](const auto& indexed_program_path) { return std::make_pair(indexed_program_path.value(), program_id(static_cast<int>(indexed_program_path.index()))); }));
 
       // プログラム毎のダイスの数。
       auto program_dice_counts = boost::copy_range<std::unordered_map<program_path_t, int>>(
         program_paths |
-        boost::adaptors::transformed([](const auto& program_path) { return std::make_pair(program_path, 5); }));
+        boost::adaptors::transformed([&](const auto& program_path) { return std::make_pair(program_path, options.rules.dice_count); }));
 
       // プログラムのプロキシー。
       auto program_proxies = boost::copy_range<std::unordered_map<program_path_t, std::shared_ptr<program_proxy>>>(
         program_paths |
-        boost::adaptors::transformed([](const auto& program_path) { return std::make_pair(program_path, std::make_shared<program_proxy>(program_path)); }));
+        boost::adaptors::transformed(
+          [](const auto& program_path) {
+            LIARS_DICE_TRACE_SCOPE("spawn", program_path);
+
+            return std::make_pair(program_path, std::make_shared<program_proxy>(program_path));
+          }));
+
+      metrics.add_live_child_process_count(static_cast<int>(std::size(program_proxies)));
 
       // 敗退者リスト。一度に複数人退場することがあるので、配列の配列にしました。
       auto losers_collection = std::vector<std::vector<program_path_t>>();
 
       // 他のプログラムの戦歴をプログラムに通知します。
       [&]() {
+        LIARS_DICE_TRACE_SCOPE("check_other_programs");
+
         const auto& careers_ = [&]() {
           const auto& program_ids_ = boost::copy_range<std::vector<program_id_t>>(
             program_paths |
@@ -181,9 +409,34 @@ namespace liars_dice {
           return careers(program_paths, program_ids_);
         }();
 
+        const auto& career_summaries = boost::copy_range<std::vector<career_summary>>(
+          program_paths |
+          boost::adaptors::transformed([&](const auto& program_path) { return career_summary{program_ids.at(program_path), program_career_statistics.at(program_path)}; }));
+
+        // プログラムはそれぞれのディレクトリで実行されるので、絶対パスで通知します。ファイルを書けなかった場合は、このセットはJSONで戦歴を送ります。
+        const auto& career_map_location = [&]() -> std::optional<liars_dice::career_map_location> {
+          if (!career_map_path_string || !boost::algorithm::any_of(program_paths, [&](const auto& program_path) { return program_capabilities_.at(program_path).count("check_other_program_map"); })) {
+            return std::nullopt;
+          }
+
+          if (!write_career_map_file(career_map_path_string.value(), careers_, ++career_map_generation)) {
+            return std::nullopt;
+          }
+
+          return liars_dice::career_map_location{career_map_path_string.value(), career_map_generation};
+        }();
+
         for (const auto& program_path: program_paths) {
           try {
-            program_proxies.at(program_path)->check_other_programs(careers_);
+            if (career_map_location && program_capabilities_.at(program_path).count("check_other_program_map")) {
+              program_proxies.at(program_path)->check_other_program_map(career_map_location.value());
+            } else {
+              program_proxies.at(program_path)->check_other_programs(careers_);
+            }
+
+            if (options.sends_career_summaries && program_capabilities_.at(program_path).count("check_career_summaries")) {
+              program_proxies.at(program_path)->check_career_summaries(career_summaries);
+            }
 
           } catch (...) {
             // program_dice_counts[program_path] = 0;
@@ -195,19 +448,23 @@ namespace liars_dice {
 
       // 最後の一人になるまでゲームを繰り返します。
       while (boost::count_if(program_dice_counts, [&](const auto& program_dice_count) { return program_dice_count.second > 0; }) > 1) {
+        LIARS_DICE_TRACE_SCOPE("game");
+
         // 今回のゲームに参加する、まだダイスが残っているプログラムを抽出します。ついでなので、ここで席順もシャッフルしておきます。
         const auto& in_game_program_paths = [&]() {
           auto result = boost::copy_range<std::vector<program_path_t>>(
             program_paths |
             boost::adaptors::filtered([&](const auto& program_path) { return program_dice_counts.at(program_path) > 0; }));
 
-          std::shuffle(std::begin(result), std::end(result), random_engine);
+          util::shuffle(result, random_engine);
 
           return result;
         }();
 
         // ゲームを実行します。
         const auto& [game, dice_count_deltas] = [&]() {
+          LIARS_DICE_TRACE_SCOPE("play_game");
+
           const auto& ids = boost::copy_range<std::vector<program_id_t>>(
             in_game_program_paths |
             boost::adaptors::transformed([&](const auto& in_game_program_path) { return program_ids.at(in_game_program_path); }));
@@ -220,11 +477,15 @@ namespace liars_dice {
             in_game_program_paths |
             boost::adaptors::transformed([&](const auto& in_game_program_path) { return [&](const auto& game) { return program_proxies.at(in_game_program_path)->action(game); }; }));
 
-          return play_game(ids, dice_counts, action_functions);
+          return play_game(ids, dice_counts, action_functions, util::mix_seed(set_seed, ++game_index), options.rules.max_bid_count);
         }();
 
         // ゲームの内容を表示します。
-        show_game(in_game_program_paths, game, dice_count_deltas);
+        [&]() {
+          LIARS_DICE_TRACE_SCOPE("show_game");
+
+          show_game(in_game_program_paths, game, dice_count_deltas);
+        }();
 
         // ゲーム終了をプログラムに通知します。昨年の「ごろごろどうぶつしょうぎ」では、この通知を入れ忘れて参加者に不便を強いてしまいました……。
         for (const auto& in_game_program_path: in_game_program_paths) {
@@ -238,6 +499,10 @@ namespace liars_dice {
           }
         }
 
+        // 計測値を更新します。
+        metrics.add_game(boost::accumulate(game.players() | boost::adaptors::transformed([](const auto& player) { return static_cast<int>(std::size(player.actions())); }), 0));
+        metrics.write_if_needed();
+
         // ゲームを、過去のゲーム集に追加します。
         [&, game = game]() {  // P0588R1...
           const auto& game_program_ids = boost::copy_range<std::unordered_map<program_path_t, program_id_t>>(
@@ -247,6 +512,11 @@ namespace liars_dice {
           past_games.emplace_back(game_program_ids, game);
         }();
 
+        // 戦歴の集計値を更新します。
+        for (auto i = 0; i < static_cast<int>(std::size(in_game_program_paths)); ++i) {
+          program_career_statistics.at(in_game_program_paths[i]).add_game(game, i);
+        }
+
         // プログラムのダイスを減らします。
         for (const auto& [in_game_program_path, dice_count_delta]: util::combine(in_game_program_paths, dice_count_deltas)) {
           program_dice_counts.at(in_game_program_path) += dice_count_delta;
@@ -280,8 +550,12 @@ namespace liars_dice {
         }
       }
 
+      metrics.add_live_child_process_count(-static_cast<int>(std::size(program_proxies)));
+
       // 標準エラー出力を出力します。
       [&]() {
+        LIARS_DICE_TRACE_SCOPE("show_logs");
+
         const auto& program_logs = boost::copy_range<std::vector<std::string>>(
           program_paths |
           boost::adaptors::transformed([&](const auto& program_path) { return program_proxies.at(program_path)->cerr(); }));
@@ -289,6 +563,14 @@ namespace liars_dice {
         show_logs(program_paths, program_logs);
       }();
 
+      // プログラムが使用したリソースを出力します。
+      show_resource_usages(program_paths, boost::copy_range<std::vector<std::shared_ptr<program_proxy>>>(program_paths | boost::adaptors::transformed([&](const auto& program_path) { return program_proxies.at(program_path); })));
+
+      // 通信の統計情報を集計します。
+      for (const auto& program_path: program_paths) {
+        program_communication_statistics.at(program_path).merge(program_proxies.at(program_path)->statistics());
+      }
+
       // 最後まで生き残ったプログラムを、最後の敗退者として登録します。
       losers_collection.emplace_back(std::vector<program_path_t>{boost::find_if(program_dice_counts, [&](const auto& program_dice_count) { return program_dice_count.second > 0; })->first});
 
@@ -297,8 +579,8 @@ namespace liars_dice {
         program_paths |
         boost::adaptors::transformed(
           [&](const auto& program_path) {
-            for (auto i = 5; i >= 0; --i) {
-              if (boost::find(losers_collection[i], program_path) != std::end(losers_collection[i])) {
+            for (auto i = static_cast<int>(std::size(losers_collection)) - 1; i >= 0; --i) {
+              if (std::find(std::begin(losers_collection[i]), std::end(losers_collection[i]), program_path) != std::end(losers_collection[i])) {
                 return static_cast<float>(boost::accumulate(boost::irange(i, i - static_cast<int>(std::size(losers_collection[i])), -1), 0)) / std::size(losers_collection[i]);
               }
             }
@@ -307,54 +589,114 @@ namespace liars_dice {
           }));
     };
 
-    // すべてのプログラムがmin_set_countで指定した回数以上のセットを実行するまでセットを繰り返す関数。
+    // スケジュールされたセットのうち、自分のシャードの担当分を実行する関数。
     const auto& play_sets = [&](const auto& program_paths) {
-      class program_evaluation final {
-        float _total_score;
-        int _set_count;
+      const auto& scheduled_sets = schedule_sets(program_paths, min_set_count, options.rules.table_size, options.seed);
 
-      public:
-        program_evaluation() noexcept: _total_score(0.0f), _set_count(0) {
-          ;
-        }
+      auto program_evaluations = boost::copy_range<std::unordered_map<program_path_t, program_evaluation>>(
+        program_paths |
+        boost::adaptors::transformed([](const auto& program_path) { return std::make_pair(program_path, program_evaluation()); }));
 
-        const auto& set_count() const noexcept {
-          return _set_count;
+      auto program_ratings = boost::copy_range<std::unordered_map<program_path_t, rating>>(
+        program_paths |
+        boost::adaptors::transformed([](const auto& program_path) { return std::make_pair(program_path, rating()); }));
+
+      if (options.resumed_checkpoint) {
+        for (const auto& [program_path, program_evaluation]: options.resumed_checkpoint->result.program_evaluations) {
+          program_evaluations.at(program_path) = program_evaluation;
         }
 
-        auto value() const noexcept {
-          return _total_score / _set_count;
+        for (const auto& [program_path, rating]: options.resumed_checkpoint->program_ratings) {
+          program_ratings.at(program_path) = rating;
         }
+      }
 
-        auto add_score(float score) noexcept {
-          _total_score += score;
+      const auto& ratings = [&]() {
+        return boost::copy_range<std::vector<rating>>(
+          program_paths |
+          boost::adaptors::transformed([&](const auto& program_path) { return program_ratings.at(program_path); }));
+      };
 
-          _set_count++;
-        }
+      const auto& current_result = [&]() {
+        return championship_result{
+          options.seed,
+          options.shard_index,
+          options.shard_count,
+          min_set_count,
+          options.rules,
+          options.is_duplicate,
+          boost::copy_range<std::vector<std::tuple<std::string, program_evaluation>>>(
+            program_paths |
+            boost::adaptors::transformed([&](const auto& program_path) { return std::make_tuple(program_path, program_evaluations.at(program_path)); }))};
       };
 
-      auto random_engine = std::mt19937_64(std::random_device()());
+      // 途中経過は、1分に1回まで出力します。past_gamesが大きくなると、毎セット出力するのは重たいので。past_gamesは、前回から増えた分だけを追記します。
+      auto checkpoint_written_time = std::chrono::steady_clock::now();
+      auto checkpoint_written_past_game_count = static_cast<std::size_t>(0);
 
-      auto program_evaluations = boost::copy_range<std::unordered_map<program_path_t, program_evaluation>>(
-        program_paths |
-        boost::adaptors::transformed([](const auto& program_path) { return std::make_pair(program_path, program_evaluation()); }));
+      for (auto i = options.resumed_checkpoint ? options.resumed_checkpoint->next_set_index : options.shard_index; i < static_cast<int>(std::size(scheduled_sets)); i += options.shard_count) {
+        const auto& sampled_program_paths = scheduled_sets[i];
+
+        // 重複（duplicate）モードの場合は、同じ種のセットをプログラムの席を一つずつずらしながら人数分実行します。全員が全ての席（のダイス）を一度ずつ担当します。
+        // スコアはデュプリケート・ブリッジのマッチポイントと同じで、同じ席を担当した他のプログラムとの一対一の比較（勝ちは1、引き分けは0.5）の合計です。同じ席の間ではダイスの運が同じなので、比較から取り除かれます。
+        // 席の数で割って、通常のモードのスコアと同じ0〜人数-1の範囲にします。
+        const auto& scores = [&]() {
+          const auto& rotation_count = options.is_duplicate ? static_cast<int>(std::size(sampled_program_paths)) : 1;
 
-      while (boost::algorithm::any_of(program_evaluations, [&](const auto& program_evaluation) { return program_evaluation.second.set_count() < min_set_count; })) {
-        const auto& sampled_program_paths = [&]() {
-          auto result = std::vector<std::string>();
+          auto rotated_scores_collection = std::vector<std::vector<float>>(); rotated_scores_collection.reserve(rotation_count);  // [ローテーション][席]。j番目のローテーションのk番目の席は、(k + j) % 人数番目のプログラムです。
 
-          std::sample(std::begin(program_paths), std::end(program_paths), std::back_inserter(result), 6, random_engine);
-          std::shuffle(std::begin(result), std::end(result), random_engine);
+          for (auto j = 0; j < rotation_count; ++j) {
+            auto rotated_program_paths = sampled_program_paths;
+            std::rotate(std::begin(rotated_program_paths), std::begin(rotated_program_paths) + j, std::end(rotated_program_paths));
+
+            rotated_scores_collection.emplace_back(play_set(rotated_program_paths, util::mix_seed(options.seed, i + 1)));
+
+            metrics.add_set(rotated_program_paths);
+            metrics.write_if_needed();
+          }
+
+          if (!options.is_duplicate) {
+            return rotated_scores_collection.front();
+          }
+
+          const auto& program_count = static_cast<int>(std::size(sampled_program_paths));
+
+          auto result = std::vector<float>(program_count, 0.0f);
+
+          for (auto k = 0; k < program_count; ++k) {
+            for (auto j = 0; j < rotation_count; ++j) {
+              for (auto l = 0; l < rotation_count; ++l) {
+                if (l == j) {
+                  continue;
+                }
+
+                const auto& score_1 = rotated_scores_collection[j][k];
+                const auto& score_2 = rotated_scores_collection[l][k];
+
+                result[(k + j) % program_count] += (score_1 > score_2 ? 1.0f : score_1 < score_2 ? 0.0f : 0.5f) / program_count;
+              }
+            }
+          }
 
           return result;
         }();
 
-        const auto& scores = play_set(sampled_program_paths);
-
         for (const auto& [program_path, score]: util::combine(sampled_program_paths, scores)) {
           program_evaluations.at(program_path).add_score(score);
         }
 
+        [&]() {
+          const auto& sampled_ratings = boost::copy_range<std::vector<rating>>(
+            sampled_program_paths |
+            boost::adaptors::transformed([&](const auto& program_path) { return program_ratings.at(program_path); }));
+
+          const auto& updated_ratings = update_ratings(sampled_ratings, scores);
+
+          for (const auto& [program_path, rating]: util::combine(sampled_program_paths, updated_ratings)) {
+            program_ratings.at(program_path) = rating;
+          }
+        }();
+
         [&]() {
           const auto& scores = boost::copy_range<std::vector<float>>(
             program_paths |
@@ -366,22 +708,70 @@ namespace liars_dice {
 
           show_scores(program_paths, scores, set_counts);
         }();
+
+        if (options.checkpoint_path_string && std::chrono::steady_clock::now() - checkpoint_written_time >= std::chrono::minutes(1)) {
+          LIARS_DICE_TRACE_SCOPE("write_checkpoint");
+
+          // past_gamesは大きいので、コピーせずに一時的にムーブします。
+          auto checkpoint = championship_checkpoint{current_result(), i + options.shard_count, std::move(past_games), boost::copy_range<std::vector<std::tuple<std::string, rating>>>(util::combine(program_paths, ratings())), options.stop_confidence};
+
+          checkpoint_written_past_game_count = write_championship_checkpoint_file(options.checkpoint_path_string.value(), checkpoint, checkpoint_written_past_game_count);
+
+          past_games = std::move(checkpoint.past_games);
+
+          checkpoint_written_time = std::chrono::steady_clock::now();
+        }
+
+        // 順位が確定したら、残りのセットは実行しません。
+        if (options.stop_confidence && is_ranking_settled(ratings(), options.stop_confidence.value())) {
+          std::cout << "# Ranking settled after " << i / options.shard_count + 1 << " sets" << std::endl;
+          std::cout << std::endl;
+
+          break;
+        }
       }
 
-      return boost::copy_range<std::vector<float>>(
-        program_paths |
-        boost::adaptors::transformed([&](const auto& program_path) { return program_evaluations.at(program_path).value(); }));
+      show_ratings(program_paths, ratings());
+
+      return current_result();
     };
 
     const auto& result = play_sets(program_path_strings);
 
+    metrics.write();
+
     // あとで何かに使えるかもしれないので、全ての試合を記録しておきます。
     [&]() {
-      auto ofstream = std::ofstream("all-games.json");
-      ofstream << write_json(past_games, std::function(write_past_games));
+      LIARS_DICE_TRACE_SCOPE("write_json");
+
+      write_past_games_file(options.games_path_string, past_games);
+    }();
+
+    // シャードの結果をまとめられるように、結果を出力します。
+    if (options.result_path_string) {
+      auto ofstream = std::ofstream(options.result_path_string.value());
+      ofstream << write_json(result, std::function(write_championship_result));
       ofstream.close();
+    }
+
+    // 通信の統計情報を出力します。タイムアウトの調整や、遅いプログラムの特定に使用してください。
+    [&]() {
+      const auto& communication_statistics_ = boost::copy_range<std::vector<communication_statistics>>(
+        program_path_strings |
+        boost::adaptors::transformed([&](const auto& program_path) { return program_communication_statistics.at(program_path); }));
+
+      show_communication_statistics(program_path_strings, communication_statistics_);
+
+      if (options.statistics_path_string) {
+        auto ofstream = std::ofstream(options.statistics_path_string.value());
+        ofstream << write_json(boost::copy_range<std::vector<std::tuple<std::string, communication_statistics>>>(util::combine(program_path_strings, communication_statistics_)), std::function(write_program_communication_statistics));
+        ofstream.close();
+      }
     }();
 
+    // トレースを出力します。makeの際にTRACE=1を指定した場合だけ。
+    LIARS_DICE_TRACE_WRITE("trace.json");
+
     return result;
   }
 }
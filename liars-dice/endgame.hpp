@@ -0,0 +1,238 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/range/adaptors.hpp>
+#include <boost/range/numeric.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "game.hpp"
+
+namespace liars_dice {
+  // 終盤の戦略表。liars-dice-endgameが、プレイヤーが少なくてダイスも少ない構成（初期値は3人以下で1人2個以下）を解いて作成します。
+  // プログラムは、ファイルをメモリにマップしておいて、ゲームがその構成になったらgame毎にO(1)で混合戦略を引けます。
+  //
+  // 宣言はbid_index()で番号にします。合法な宣言は、直前の宣言より番号が大きい宣言です。宣言の番号0は、まだ宣言がないことを表します。
+  // 全員のダイスの数より大きな個数の宣言は、チャレンジされれば必ず負けるので、表には含めません。
+  //
+  // ヘッダー（32バイト）: "LDENDGM"、バージョン（1バイト）、プレイヤーの最大数（4バイト）、ダイスの最大数（4バイト）、構成の数（4バイト）、予備（12バイト）
+  // 構成の索引:          構成毎のオフセット（8バイトずつ）
+  // 構成:                ダイスの数の合計（4バイト）、手の数（4バイト）、
+  //                      確率（2バイトずつ。65535が1。[手番のプレイヤー][手の番号][直前の宣言の番号][手（0はチャレンジ、1以降は宣言の番号）]）
+  //
+  // 構成は、プレイヤーの数毎に、最初に宣言するプレイヤーから順にダイスの数を並べた数を、ダイスの最大数進数として見た順番に並べます。
+
+  constexpr auto endgame_table_magic       = "LDENDGM";
+  constexpr auto endgame_table_version     = 1;
+  constexpr auto endgame_table_header_size = 32;
+  constexpr auto endgame_probability_scale = 65535;
+
+  inline auto endgame_configuration_count(int max_player_count, int max_dice_count) noexcept {
+    auto result = 0;
+
+    for (auto player_count = 2; player_count <= max_player_count; ++player_count) {
+      auto configuration_count = 1;
+
+      for (auto i = 0; i < player_count; ++i) {
+        configuration_count *= max_dice_count;
+      }
+
+      result += configuration_count;
+    }
+
+    return result;
+  }
+
+  // 構成の番号。表の範囲外なら-1を返します。
+  inline auto endgame_configuration_index(const std::vector<int>& dice_counts, int max_player_count, int max_dice_count) noexcept {
+    const auto& player_count = static_cast<int>(std::size(dice_counts));
+
+    if (player_count < 2 || player_count > max_player_count) {
+      return -1;
+    }
+
+    auto result = endgame_configuration_count(player_count - 1, max_dice_count);
+
+    auto index = 0;
+
+    for (const auto& dice_count: dice_counts) {
+      if (dice_count < 1 || dice_count > max_dice_count) {
+        return -1;
+      }
+
+      index = index * max_dice_count + dice_count - 1;
+    }
+
+    return result + index;
+  }
+
+  inline auto endgame_configuration_dice_counts(int configuration_index, int max_player_count, int max_dice_count) noexcept {
+    auto player_count = 2;
+
+    while (configuration_index >= endgame_configuration_count(player_count, max_dice_count)) {
+      ++player_count;
+    }
+
+    auto index = configuration_index - endgame_configuration_count(player_count - 1, max_dice_count);
+
+    auto result = std::vector<int>(player_count);
+
+    for (auto i = player_count - 1; i >= 0; --i) {
+      result[i] = index % max_dice_count + 1;
+      index /= max_dice_count;
+    }
+
+    return result;
+  }
+
+  // 構成毎の戦略。probabilitiesは、[手番のプレイヤー][手の番号][直前の宣言の番号][手]の並びです。
+  struct endgame_strategy final {
+    std::vector<int> dice_counts;
+    std::vector<std::uint16_t> probabilities;
+  };
+
+  inline auto endgame_hand_count(const std::vector<int>& dice_counts) noexcept {
+    return hand_count(*std::max_element(std::begin(dice_counts), std::end(dice_counts)));
+  }
+
+  inline auto endgame_bid_count(const std::vector<int>& dice_counts) noexcept {
+    return boost::accumulate(dice_counts, 0) * 5;
+  }
+
+  // object -> binary
+
+  inline auto write_endgame_table(int max_player_count, int max_dice_count, const std::vector<endgame_strategy>& endgame_strategies) {
+    const auto& put_uint = [](std::string& buffer, std::uint64_t value, int byte_count) {
+      for (auto i = 0; i < byte_count; ++i) {
+        buffer.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+      }
+    };
+
+    const auto& configuration_count = endgame_configuration_count(max_player_count, max_dice_count);
+
+    auto result = std::string(endgame_table_magic);
+
+    result.push_back(static_cast<char>(endgame_table_version));
+    put_uint(result, max_player_count, 4);
+    put_uint(result, max_dice_count, 4);
+    put_uint(result, configuration_count, 4);
+    put_uint(result, 0, 12);
+
+    auto offsets = std::vector<std::uint64_t>(configuration_count, 0);
+    auto body    = std::string();
+
+    for (const auto& endgame_strategy: endgame_strategies) {
+      offsets[endgame_configuration_index(endgame_strategy.dice_counts, max_player_count, max_dice_count)] = endgame_table_header_size + configuration_count * 8 + std::size(body);
+
+      put_uint(body, boost::accumulate(endgame_strategy.dice_counts, 0), 4);
+      put_uint(body, endgame_hand_count(endgame_strategy.dice_counts), 4);
+
+      for (const auto& probability: endgame_strategy.probabilities) {
+        put_uint(body, probability, 2);
+      }
+    }
+
+    for (const auto& offset: offsets) {
+      put_uint(result, offset, 8);
+    }
+
+    result.append(body);
+
+    return result;
+  }
+
+  // binary -> object
+
+  class endgame_table final {
+    boost::interprocess::file_mapping _file_mapping;
+    boost::interprocess::mapped_region _mapped_region;
+    const unsigned char* _data;
+    int _max_player_count;
+    int _max_dice_count;
+
+    auto get_uint(std::uint64_t offset, int byte_count) const noexcept {
+      auto result = static_cast<std::uint64_t>(0);
+
+      for (auto i = 0; i < byte_count; ++i) {
+        result |= static_cast<std::uint64_t>(_data[offset + i]) << (i * 8);
+      }
+
+      return result;
+    }
+
+  public:
+    endgame_table(const std::string& path_string): _file_mapping(path_string.c_str(), boost::interprocess::read_only), _mapped_region(_file_mapping, boost::interprocess::read_only), _data(static_cast<const unsigned char*>(_mapped_region.get_address())) {
+      if (_mapped_region.get_size() < endgame_table_header_size || std::string(reinterpret_cast<const char*>(_data), 7) != endgame_table_magic || _data[7] != endgame_table_version) {
+        throw std::runtime_error("not an endgame table: " + path_string);
+      }
+
+      _max_player_count = static_cast<int>(get_uint(8, 4));
+      _max_dice_count   = static_cast<int>(get_uint(12, 4));
+    }
+
+    auto max_player_count() const noexcept {
+      return _max_player_count;
+    }
+
+    auto max_dice_count() const noexcept {
+      return _max_dice_count;
+    }
+
+    // gameが表にある構成なら、手番のプレイヤーの混合戦略（手と確率の組）を返します。gameの最初のプレイヤーが、最初に宣言したプレイヤーでなければなりません。
+    auto strategy(const game& game) const noexcept -> std::optional<std::vector<std::tuple<action, float>>> {
+      const auto& dice_counts = boost::copy_range<std::vector<int>>(game.players() | boost::adaptors::transformed([](const auto& player) { return static_cast<int>(std::size(player.faces())); }));
+
+      const auto& configuration_index = endgame_configuration_index(dice_counts, _max_player_count, _max_dice_count);
+
+      if (configuration_index < 0) {
+        return std::nullopt;
+      }
+
+      const auto& offset = get_uint(endgame_table_header_size + configuration_index * 8, 8);
+
+      if (offset == 0) {
+        return std::nullopt;
+      }
+
+      const auto& total_dice_count = static_cast<int>(get_uint(offset + 0, 4));
+      const auto& hand_count       = static_cast<int>(get_uint(offset + 4, 4));
+      const auto& bid_count        = total_dice_count * 5;
+
+      const auto& previous_actions = game.players()[game.previous_player_index()].actions();
+      const auto& previous_bid_index = std::empty(previous_actions) ? 0 : bid_index(previous_actions.back().bid().value());
+
+      if (previous_bid_index > bid_count || game.max_bid_count() < total_dice_count) {
+        return std::nullopt;
+      }
+
+      const auto& row_offset = offset + 8 + ((static_cast<std::uint64_t>(game.player_index()) * hand_count + hand_index(game.players()[game.player_index()].faces())) * (bid_count + 1) + previous_bid_index) * (bid_count + 1) * 2;
+
+      auto result = std::vector<std::tuple<action, float>>();
+
+      for (auto i = 0; i <= bid_count; ++i) {
+        const auto& probability = static_cast<int>(get_uint(row_offset + i * 2, 2));
+
+        if (probability == 0) {
+          continue;
+        }
+
+        result.emplace_back(i == 0 ? action(challenge()) : action(index_bid(i)), static_cast<float>(probability) / endgame_probability_scale);
+      }
+
+      return result;
+    }
+  };
+}
@@ -0,0 +1,391 @@
+﻿#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../endgame.hpp"
+#include "../game.hpp"
+#include "../util.hpp"
+
+// 終盤の戦略表を作成します。プレイヤーの数とダイスの数の全ての構成について、CFR+で近似ナッシュ均衡の混合戦略を求めます。
+// 完全記憶にすると宣言の履歴の分だけ情報集合が指数的に増えてしまうので、情報集合は(手番のプレイヤー, 自分の手, 直前の宣言)にしました（Dudoの研究でよく使われる抽象化です）。
+// 直前の宣言の番号は単調に増えるので、状態(直前の宣言, 手番のプレイヤー)はDAGになって、到達確率と価値を動的計画法で求められます。
+
+class endgame_solver final {
+  std::vector<int> _dice_counts;
+  int _player_count;
+  int _bid_count;
+  int _hand_count;
+
+  // 全員の手の組み合わせ。
+  int _joint_hand_count;
+  std::vector<int> _joint_hands;                   // [組み合わせ][プレイヤー]
+  std::vector<double> _joint_hand_probabilities;   // [組み合わせ]
+  std::vector<int> _joint_face_counts;             // [組み合わせ][目]（☆を含む）
+
+  std::vector<double> _regrets;                    // [プレイヤー][手][直前の宣言][手]
+  std::vector<double> _strategy_sums;
+  std::vector<double> _strategy;
+
+  std::vector<double> _reaches;                    // [直前の宣言][プレイヤー][組み合わせ][そのプレイヤー以外の（偶然を含む）到達確率 * プレイヤーの数 + そのプレイヤー自身の到達確率 * プレイヤーの数]
+  std::vector<double> _values;                     // [直前の宣言][プレイヤー][組み合わせ][プレイヤー]
+
+  auto infoset_index(int player_index, int hand_index, int previous_bid_index) const noexcept {
+    return ((static_cast<std::size_t>(player_index) * _hand_count + hand_index) * (_bid_count + 1) + previous_bid_index) * (_bid_count + 1);
+  }
+
+  auto state_index(int previous_bid_index, int player_index) const noexcept {
+    return static_cast<std::size_t>(previous_bid_index) * _player_count + player_index;
+  }
+
+  // チャレンジされた場合の、各プレイヤーのダイスの増減。持っている以上のダイスは失いません。
+  auto terminal_values(int bid_index, int challenger_index, int joint_hand_index, double* values) const noexcept {
+    const auto& bid          = liars_dice::index_bid(bid_index);
+    const auto& face_count   = _joint_face_counts[joint_hand_index * 7 + bid.face()];
+    const auto& bidder_index = (challenger_index + _player_count - 1) % _player_count;
+
+    std::fill(values, values + _player_count, 0.0);
+
+    if (face_count < bid.min_count()) {
+      values[bidder_index] = -std::min(bid.min_count() - face_count, _dice_counts[bidder_index]);
+
+      return;
+    }
+
+    if (face_count > bid.min_count()) {
+      values[challenger_index] = -std::min(face_count - bid.min_count(), _dice_counts[challenger_index]);
+
+      return;
+    }
+
+    for (auto i = 0; i < _player_count; ++i) {
+      if (i != bidder_index) {
+        values[i] = -1;
+      }
+    }
+  }
+
+  // 後ろ向きに、strategyでの価値を計算します。is_updatingなら、同時にリグレットと平均戦略を更新します。
+  auto backward(const std::vector<double>& strategy, bool is_updating, double weight) noexcept {
+    auto action_values = std::vector<double>((_bid_count + 1) * _player_count);
+
+    for (auto previous_bid_index = _bid_count; previous_bid_index >= 0; --previous_bid_index) {
+      for (auto player_index = 0; player_index < _player_count; ++player_index) {
+        if (previous_bid_index == 0 && player_index != 0) {
+          continue;
+        }
+
+        const auto& next_player_index = (player_index + 1) % _player_count;
+
+        for (auto joint_hand_index = 0; joint_hand_index < _joint_hand_count; ++joint_hand_index) {
+          const auto& hand_index = _joint_hands[joint_hand_index * _player_count + player_index];
+          const auto& infoset    = infoset_index(player_index, hand_index, previous_bid_index);
+
+          auto* values = &_values[(state_index(previous_bid_index, player_index) * _joint_hand_count + joint_hand_index) * _player_count];
+
+          std::fill(values, values + _player_count, 0.0);
+
+          for (auto action_index = previous_bid_index == 0 ? 1 : 0; action_index <= _bid_count; ++action_index) {
+            if (action_index != 0 && action_index <= previous_bid_index) {
+              continue;
+            }
+
+            auto* action_values_ = &action_values[action_index * _player_count];
+
+            if (action_index == 0) {
+              terminal_values(previous_bid_index, player_index, joint_hand_index, action_values_);
+            } else {
+              const auto* child_values_ = &_values[(state_index(action_index, next_player_index) * _joint_hand_count + joint_hand_index) * _player_count];
+
+              std::copy(child_values_, child_values_ + _player_count, action_values_);
+            }
+
+            for (auto i = 0; i < _player_count; ++i) {
+              values[i] += strategy[infoset + action_index] * action_values_[i];
+            }
+          }
+
+          if (!is_updating) {
+            continue;
+          }
+
+          const auto* reaches = &_reaches[(state_index(previous_bid_index, player_index) * _joint_hand_count + joint_hand_index) * _player_count * 2];
+
+          for (auto action_index = previous_bid_index == 0 ? 1 : 0; action_index <= _bid_count; ++action_index) {
+            if (action_index != 0 && action_index <= previous_bid_index) {
+              continue;
+            }
+
+            _regrets[infoset + action_index]       += reaches[player_index] * (action_values[action_index * _player_count + player_index] - values[player_index]);
+            _strategy_sums[infoset + action_index] += weight * reaches[_player_count + player_index] * strategy[infoset + action_index];  // 平均戦略は、手番のプレイヤー自身の到達確率で重み付けします。
+          }
+        }
+
+        // CFR+なので、リグレットは負にしません。
+        if (is_updating) {
+          for (auto hand_index = 0; hand_index < _hand_count; ++hand_index) {
+            const auto& infoset = infoset_index(player_index, hand_index, previous_bid_index);
+
+            for (auto action_index = 0; action_index <= _bid_count; ++action_index) {
+              _regrets[infoset + action_index] = std::max(_regrets[infoset + action_index], 0.0);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // 前向きに、到達確率を計算します。
+  auto forward() noexcept {
+    std::fill(std::begin(_reaches), std::end(_reaches), 0.0);
+
+    for (auto joint_hand_index = 0; joint_hand_index < _joint_hand_count; ++joint_hand_index) {
+      auto* reaches = &_reaches[(state_index(0, 0) * _joint_hand_count + joint_hand_index) * _player_count * 2];
+
+      std::fill(reaches, reaches + _player_count, _joint_hand_probabilities[joint_hand_index]);
+      std::fill(reaches + _player_count, reaches + _player_count * 2, 1.0);
+    }
+
+    for (auto previous_bid_index = 0; previous_bid_index < _bid_count; ++previous_bid_index) {
+      for (auto player_index = 0; player_index < _player_count; ++player_index) {
+        if (previous_bid_index == 0 && player_index != 0) {
+          continue;
+        }
+
+        const auto& next_player_index = (player_index + 1) % _player_count;
+
+        for (auto joint_hand_index = 0; joint_hand_index < _joint_hand_count; ++joint_hand_index) {
+          const auto* reaches = &_reaches[(state_index(previous_bid_index, player_index) * _joint_hand_count + joint_hand_index) * _player_count * 2];
+          const auto& infoset = infoset_index(player_index, _joint_hands[joint_hand_index * _player_count + player_index], previous_bid_index);
+
+          for (auto action_index = previous_bid_index + 1; action_index <= _bid_count; ++action_index) {
+            const auto& probability = _strategy[infoset + action_index];
+
+            auto* child_reaches = &_reaches[(state_index(action_index, next_player_index) * _joint_hand_count + joint_hand_index) * _player_count * 2];
+
+            for (auto i = 0; i < _player_count; ++i) {
+              child_reaches[i]                 += reaches[i]                 * (i == player_index ? 1.0 : probability);
+              child_reaches[_player_count + i] += reaches[_player_count + i] * (i == player_index ? probability : 1.0);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // weightsに比例する確率。正のweightsがなければ、合法な手から一様に選びます。
+  auto normalize(const double* weights, double* probabilities, int previous_bid_index) const noexcept {
+    const auto& is_legal = [&](const auto& action_index) { return action_index == 0 ? previous_bid_index > 0 : action_index > previous_bid_index; };
+
+    auto sum   = 0.0;
+    auto count = 0;
+
+    for (auto action_index = 0; action_index <= _bid_count; ++action_index) {
+      if (is_legal(action_index)) {
+        sum += weights[action_index];
+        count++;
+      }
+    }
+
+    for (auto action_index = 0; action_index <= _bid_count; ++action_index) {
+      probabilities[action_index] = !is_legal(action_index) ? 0.0 : sum > 0 ? weights[action_index] / sum : 1.0 / count;
+    }
+  }
+
+  // リグレットに比例する戦略。
+  auto update_strategy() noexcept {
+    for (auto player_index = 0; player_index < _player_count; ++player_index) {
+      for (auto hand_index = 0; hand_index < _hand_count; ++hand_index) {
+        for (auto previous_bid_index = 0; previous_bid_index <= _bid_count; ++previous_bid_index) {
+          const auto& infoset = infoset_index(player_index, hand_index, previous_bid_index);
+
+          normalize(&_regrets[infoset], &_strategy[infoset], previous_bid_index);
+        }
+      }
+    }
+  }
+
+public:
+  endgame_solver(const std::vector<int>& dice_counts): _dice_counts(dice_counts), _player_count(static_cast<int>(std::size(dice_counts))), _bid_count(liars_dice::endgame_bid_count(dice_counts)), _hand_count(liars_dice::endgame_hand_count(dice_counts)) {
+    // プレイヤー毎の、手と確率と目毎のダイスの数。
+    const auto& hands_collection = boost::copy_range<std::vector<std::vector<std::tuple<double, std::array<int, 7>>>>>(
+      dice_counts |
+      boost::adaptors::transformed(
+        [&](const auto& dice_count) {
+          auto result = std::vector<std::tuple<double, std::array<int, 7>>>(liars_dice::hand_count(dice_count));
+
+          // 全ての目の並びを列挙して、手毎に数えます。
+          auto faces = std::vector<int>(dice_count, 1);
+
+          for (;;) {
+            auto& [probability, face_counts] = result[liars_dice::hand_index(faces)];
+
+            probability += std::pow(1.0 / 6, dice_count);
+
+            for (auto face = 2; face <= 6; ++face) {
+              face_counts[face] = static_cast<int>(std::count_if(std::begin(faces), std::end(faces), [&](const auto& face_) { return face_ == 1 || face_ == face; }));
+            }
+
+            auto i = 0;
+
+            for (; i < dice_count && faces[i] == 6; ++i) {
+              faces[i] = 1;
+            }
+
+            if (i == dice_count) {
+              break;
+            }
+
+            faces[i]++;
+          }
+
+          return result;
+        }));
+
+    _joint_hand_count = boost::accumulate(hands_collection | boost::adaptors::transformed([](const auto& hands) { return static_cast<int>(std::size(hands)); }), 1, std::multiplies<int>());
+
+    _joint_hands.resize(static_cast<std::size_t>(_joint_hand_count) * _player_count);
+    _joint_hand_probabilities.resize(_joint_hand_count);
+    _joint_face_counts.resize(static_cast<std::size_t>(_joint_hand_count) * 7);
+
+    for (auto joint_hand_index = 0; joint_hand_index < _joint_hand_count; ++joint_hand_index) {
+      auto index = joint_hand_index;
+
+      _joint_hand_probabilities[joint_hand_index] = 1.0;
+
+      for (auto i = _player_count - 1; i >= 0; --i) {
+        const auto& hand_index = index % static_cast<int>(std::size(hands_collection[i]));
+        const auto& [probability, face_counts] = hands_collection[i][hand_index];
+
+        _joint_hands[joint_hand_index * _player_count + i] = hand_index;
+        _joint_hand_probabilities[joint_hand_index] *= probability;
+
+        for (auto face = 2; face <= 6; ++face) {
+          _joint_face_counts[joint_hand_index * 7 + face] += face_counts[face];
+        }
+
+        index /= static_cast<int>(std::size(hands_collection[i]));
+      }
+    }
+
+    const auto& infoset_size = static_cast<std::size_t>(_player_count) * _hand_count * (_bid_count + 1) * (_bid_count + 1);
+
+    _regrets.resize(infoset_size);
+    _strategy_sums.resize(infoset_size);
+    _strategy.resize(infoset_size);
+
+    _reaches.resize(static_cast<std::size_t>(_bid_count + 1) * _player_count * _joint_hand_count * _player_count * 2);
+    _values.resize(static_cast<std::size_t>(_bid_count + 1) * _player_count * _joint_hand_count * _player_count);
+  }
+
+  const auto& dice_counts() const noexcept {
+    return _dice_counts;
+  }
+
+  // CFR+の1回分。平均戦略は、反復の回数で重み付けします。
+  auto iterate(int iteration) noexcept {
+    update_strategy();
+    forward();
+    backward(_strategy, true, iteration);
+  }
+
+  // 平均戦略。
+  auto average_strategy() const noexcept {
+    auto result = std::vector<double>(std::size(_strategy_sums));
+
+    for (auto player_index = 0; player_index < _player_count; ++player_index) {
+      for (auto hand_index = 0; hand_index < _hand_count; ++hand_index) {
+        for (auto previous_bid_index = 0; previous_bid_index <= _bid_count; ++previous_bid_index) {
+          const auto& infoset = infoset_index(player_index, hand_index, previous_bid_index);
+
+          normalize(&_strategy_sums[infoset], &result[infoset], previous_bid_index);
+        }
+      }
+    }
+
+    return result;
+  }
+
+  // 平均戦略で対戦した場合の、プレイヤー毎のダイスの増減の期待値。
+  auto average_values() noexcept {
+    backward(average_strategy(), false, 0);
+
+    auto result = std::vector<double>(_player_count, 0.0);
+
+    for (auto joint_hand_index = 0; joint_hand_index < _joint_hand_count; ++joint_hand_index) {
+      for (auto i = 0; i < _player_count; ++i) {
+        result[i] += _joint_hand_probabilities[joint_hand_index] * _values[(state_index(0, 0) * _joint_hand_count + joint_hand_index) * _player_count + i];
+      }
+    }
+
+    return result;
+  }
+
+  auto endgame_strategy() const noexcept {
+    return liars_dice::endgame_strategy{
+      _dice_counts,
+      boost::copy_range<std::vector<std::uint16_t>>(average_strategy() | boost::adaptors::transformed([](const auto& probability) { return static_cast<std::uint16_t>(std::round(probability * liars_dice::endgame_probability_scale)); }))};
+  }
+};
+
+int main(int argc, char** argv) {
+  if (argc < 2 || argc > 5) {
+    std::cerr << "usage: liars-dice-endgame table-path [max-player-count [max-dice-count [iteration-count]]]" << std::endl;
+    std::exit(1);
+  }
+
+  const auto& max_player_count = argc > 2 ? std::stoi(argv[2]) : 3;
+  const auto& max_dice_count   = argc > 3 ? std::stoi(argv[3]) : 2;
+  const auto& iteration_count  = argc > 4 ? std::stoi(argv[4]) : 1000;
+
+  const auto& configuration_count = liars_dice::endgame_configuration_count(max_player_count, max_dice_count);
+
+  auto endgame_strategies = std::vector<liars_dice::endgame_strategy>(configuration_count);
+  auto average_values     = std::vector<std::vector<double>>(configuration_count);
+  auto seconds            = std::vector<double>(configuration_count);
+
+  // 構成毎に、並列で解きます。
+  util::parallel_for(
+    configuration_count,
+    [&](const auto& i) {
+      const auto& starting_time = std::chrono::steady_clock::now();
+
+      auto endgame_solver_ = endgame_solver(liars_dice::endgame_configuration_dice_counts(i, max_player_count, max_dice_count));
+
+      for (auto iteration = 1; iteration <= iteration_count; ++iteration) {
+        endgame_solver_.iterate(iteration);
+      }
+
+      endgame_strategies[i] = endgame_solver_.endgame_strategy();
+      average_values[i]     = endgame_solver_.average_values();
+      seconds[i]            = std::chrono::duration<double>(std::chrono::steady_clock::now() - starting_time).count();
+    });
+
+  for (auto i = 0; i < configuration_count; ++i) {
+    for (const auto& dice_count: endgame_strategies[i].dice_counts) {
+      std::cout << dice_count << " ";
+    }
+
+    std::cout << "\t";
+
+    for (const auto& average_value: average_values[i]) {
+      std::cout << std::fixed << std::setprecision(3) << average_value << std::defaultfloat << " ";
+    }
+
+    std::cout << "\t" << std::fixed << std::setprecision(3) << seconds[i] << " sec" << std::defaultfloat << std::endl;
+  }
+
+  auto ofstream = std::ofstream(argv[1], std::ios::out | std::ios::binary);
+  ofstream << liars_dice::write_endgame_table(max_player_count, max_dice_count, endgame_strategies);
+  ofstream.close();
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/range/adaptors.hpp>
+#include <boost/range/numeric.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "game.hpp"
+#include "replay.hpp"
+
+namespace liars_dice {
+  // プレイヤー判別（doc/check-other-programs.md）の入力。1手分が20個の数値で、5手分をまとめて100個の数値にします。
+  constexpr auto move_feature_size   = 20;
+  constexpr auto window_move_count   = 5;
+  constexpr auto window_feature_size = move_feature_size * window_move_count;
+
+  // 出力は、hardhead（csharpとjavaを含む）、fool、optimist、pessimist、timidの5クラス。
+  constexpr auto program_class_count = 5;
+
+  using move_features   = std::array<float, move_feature_size>;
+  using window_features = std::array<float, window_feature_size>;
+
+  // 1手分の特徴量。
+  //   0〜5:   自分の、出目が☆、2、3、4、5、6になっているサイコロの数
+  //   6:      自分以外のプレイヤーのサイコロの数の合計
+  //   7〜11:  前のプレイヤーが、2〜6の目で宣言したかどうか
+  //   12:     前のプレイヤーが、n以上として宣言した値
+  //   13〜17: 自分が、2〜6の目で宣言したかどうか
+  //   18:     自分が、n以上として宣言した値
+  //   19:     チャレンジしていれば1、そうでなければ0
+  inline auto get_move_features(const game& game, const action& action) noexcept {
+    auto result = move_features{};
+
+    const auto& player = game.players()[game.player_index()];
+
+    for (const auto& face: player.faces()) {
+      if (face >= 1 && face <= 6) {
+        result[face - 1] += 1;
+      }
+    }
+
+    result[6] = static_cast<float>(boost::accumulate(game.players() | boost::adaptors::transformed([](const auto& player) { return static_cast<int>(std::size(player.faces())); }), 0) - static_cast<int>(std::size(player.faces())));
+
+    const auto& previous_actions = game.players()[game.previous_player_index()].actions();
+
+    if (!std::empty(previous_actions) && previous_actions.back().bid()) {
+      const auto& previous_bid = previous_actions.back().bid().value();
+
+      if (previous_bid.face() >= 2 && previous_bid.face() <= 6) {
+        result[7 + previous_bid.face() - 2] = 1;
+      }
+
+      result[12] = static_cast<float>(previous_bid.min_count());
+    }
+
+    if (action.bid()) {
+      if (action.bid()->face() >= 2 && action.bid()->face() <= 6) {
+        result[13 + action.bid()->face() - 2] = 1;
+      }
+
+      result[18] = static_cast<float>(action.bid()->min_count());
+    }
+
+    if (action.challenge()) {
+      result[19] = 1;
+    }
+
+    return result;
+  }
+
+  // ゲームの中の、idのプレイヤーの全ての手の特徴量。
+  inline auto get_player_move_features(const game& game, const std::string& id) {
+    auto result = std::vector<move_features>();
+
+    for_each_recorded_action(
+      game,
+      [&](const auto& game, const auto& action) {
+        if (game.players()[game.player_index()].id() == id) {
+          result.emplace_back(get_move_features(game, action));
+        }
+      });
+
+    return result;
+  }
+
+  // 手の特徴量を、先頭から5手ずつにまとめます。5手に満たない残りは捨てます。
+  inline auto get_window_features(const std::vector<move_features>& move_features_collection) noexcept {
+    auto result = std::vector<window_features>(); result.reserve(std::size(move_features_collection) / window_move_count);
+
+    for (auto i = 0; i + window_move_count <= static_cast<int>(std::size(move_features_collection)); i += window_move_count) {
+      auto window_features_ = window_features{};
+
+      for (auto j = 0; j < window_move_count; ++j) {
+        std::copy(std::begin(move_features_collection[i + j]), std::end(move_features_collection[i + j]), std::begin(window_features_) + j * move_feature_size);
+      }
+
+      result.emplace_back(window_features_);
+    }
+
+    return result;
+  }
+}
@@ -0,0 +1,134 @@
+﻿#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/filesystem.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "../features.hpp"
+#include "../game.hpp"
+#include "../game_log.hpp"
+#include "../util.hpp"
+
+// doc/check-other-programs.mdのプレイヤー判別の学習データを作成します。
+// 入力は、all-games.json（もしくはバイナリ形式のゲーム・ログ）。出力は、NumPyの.npy形式の、(n, 100)のfloat32のxと、(n,)のint32のy。
+
+// プログラムのディレクトリ名から、正解のクラスを求めます。csharpとjavaは、アルゴリズム的にはhardheadと同じなのでhardheadに含めます。
+inline auto program_class(const std::string& program_path_string) {
+  const auto& directory_path = boost::filesystem::path(program_path_string).parent_path().filename();
+  const auto& directory_name = directory_path.string();
+
+  for (const auto& [prefix, class_] : std::vector<std::tuple<std::string, int>>{{"hardhead", 0}, {"csharp", 0}, {"java", 0}, {"fool", 1}, {"optimist", 2}, {"pessimist", 3}, {"timid", 4}}) {
+    if (directory_name.rfind(prefix, 0) == 0) {
+      return class_;
+    }
+  }
+
+  return -1;
+}
+
+// NumPyの.npy形式（バージョン1.0）で出力します。リトル・エンディアンの環境を前提にしています。
+inline auto write_npy(const std::string& path_string, const std::string& descr, const std::string& shape, const char* data, std::size_t byte_count) {
+  auto header = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': " + shape + ", }";
+
+  header.append(64 - (10 + std::size(header) + 1) % 64, ' ');
+  header.push_back('\n');
+
+  auto ofstream = std::ofstream(path_string, std::ios::out | std::ios::binary);
+
+  ofstream.write("\x93NUMPY\x01\x00", 8);
+  ofstream.put(static_cast<char>(std::size(header) & 0xff));
+  ofstream.put(static_cast<char>(std::size(header) >> 8));
+  ofstream.write(header.c_str(), std::size(header));
+  ofstream.write(data, byte_count);
+  ofstream.close();
+}
+
+int main(int argc, char** argv) {
+  if (argc < 4) {
+    std::cerr << "usage: liars-dice-features xs-path ys-path games-path [games-path ...]" << std::endl;
+    std::exit(1);
+  }
+
+  const auto& starting_time = std::chrono::steady_clock::now();
+
+  // ファイルを、並列で読み込みます。
+  const auto& games_path_strings = std::vector<std::string>(argv + 3, argv + argc);
+
+  auto past_games_collection = std::vector<std::vector<std::tuple<std::unordered_map<std::string, std::string>, liars_dice::game>>>(std::size(games_path_strings));
+
+  util::parallel_for(static_cast<int>(std::size(games_path_strings)), [&](const auto& i) { past_games_collection[i] = liars_dice::read_past_games_file(games_path_strings[i]); });
+
+  const auto& past_games = [&]() {
+    auto result = std::vector<const std::tuple<std::unordered_map<std::string, std::string>, liars_dice::game>*>();
+
+    for (const auto& past_games: past_games_collection) {
+      for (const auto& past_game: past_games) {
+        result.emplace_back(&past_game);
+      }
+    }
+
+    return result;
+  }();
+
+  // ゲーム毎に、並列で特徴量を作成します。
+  auto game_program_move_features = std::vector<std::vector<std::tuple<std::string, std::vector<liars_dice::move_features>>>>(std::size(past_games));
+
+  util::parallel_for(
+    static_cast<int>(std::size(past_games)),
+    [&](const auto& i) {
+      const auto& [program_path_and_program_ids, game] = *past_games[i];
+
+      for (const auto& [program_path, program_id]: program_path_and_program_ids) {
+        if (program_class(program_path) < 0) {
+          continue;
+        }
+
+        game_program_move_features[i].emplace_back(program_path, liars_dice::get_player_move_features(game, program_id));
+      }
+    });
+
+  // プログラム毎に、ゲームの順番で手を並べて、5手ずつにまとめます。
+  auto xs = std::vector<liars_dice::window_features>();
+  auto ys = std::vector<std::int32_t>();
+
+  [&]() {
+    auto program_move_features = std::map<std::string, std::vector<liars_dice::move_features>>();
+
+    for (const auto& program_move_features_: game_program_move_features) {
+      for (const auto& [program_path, move_features_collection]: program_move_features_) {
+        auto& move_features_collection_ = program_move_features[program_path];
+
+        move_features_collection_.insert(std::end(move_features_collection_), std::begin(move_features_collection), std::end(move_features_collection));
+      }
+    }
+
+    for (const auto& [program_path, move_features_collection]: program_move_features) {
+      for (const auto& window_features: liars_dice::get_window_features(move_features_collection)) {
+        xs.emplace_back(window_features);
+        ys.emplace_back(program_class(program_path));
+      }
+    }
+  }();
+
+  write_npy(argv[1], "<f4", "(" + std::to_string(std::size(xs)) + ", " + std::to_string(liars_dice::window_feature_size) + ")", reinterpret_cast<const char*>(std::data(xs)), std::size(xs) * sizeof(liars_dice::window_features));
+  write_npy(argv[2], "<i4", "(" + std::to_string(std::size(ys)) + ",)", reinterpret_cast<const char*>(std::data(ys)), std::size(ys) * sizeof(std::int32_t));
+
+  std::cout << "games\t" << std::size(past_games) << std::endl;
+  std::cout << "windows\t" << std::size(xs) << std::endl;
+  std::cout << "seconds\t" << std::fixed << std::setprecision(3) << std::chrono::duration<double>(std::chrono::steady_clock::now() - starting_time).count() << std::defaultfloat << std::endl;
+
+  return 0;
+}
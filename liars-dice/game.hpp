@@ -1,7 +1,12 @@
 ﻿#pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <optional>
-#include <unordered_map>
+#include <random>
+#include <string>
 #include <vector>
 
 #ifdef _MSC_VER
@@ -67,11 +72,12 @@ namespace liars_dice {
     std::vector<action> _actions;
 
   public:
-    player(const std::string& id, const std::vector<int>& faces, const std::vector<action>& actions) noexcept: _id(id), _faces(faces), _actions(actions) {
+    // 値で受け取ってムーブするので、呼び出し側でstd::moveすれば、vectorを確保し直しません。
+    player(std::string id, std::vector<int> faces, std::vector<action> actions) noexcept: _id(std::move(id)), _faces(std::move(faces)), _actions(std::move(actions)) {
       ;
     }
 
-    player(const std::string& id, const std::vector<int>& faces) noexcept: player(id, faces, {}) {
+    player(std::string id, std::vector<int> faces) noexcept: player(std::move(id), std::move(faces), {}) {
       ;
     }
 
@@ -79,6 +85,10 @@ namespace liars_dice {
       return _id;
     }
 
+    auto& id() noexcept {
+      return _id;
+    }
+
     const auto& faces() const noexcept {
       return _faces;
     }
@@ -96,59 +106,214 @@ namespace liars_dice {
     }
   };
 
+  // 宣言の番号。(個数, 目)の辞書順に1から振るので、直前の宣言より番号が大きい宣言が合法な宣言になります。
+  inline auto bid_index(const bid& bid) noexcept {
+    return (bid.min_count() - 1) * 5 + (bid.face() - 2) + 1;
+  }
+
+  inline auto index_bid(int index) noexcept {
+    return bid((index - 1) % 5 + 2, (index - 1) / 5 + 1);
+  }
+
+  inline auto binomial(int n, int k) noexcept {
+    if (k < 0 || k > n) {
+      return 0;
+    }
+
+    auto result = 1;
+
+    for (auto i = 1; i <= k; ++i) {
+      result = result * (n - k + i) / i;
+    }
+
+    return result;
+  }
+
+  // 手（ダイスの目の組み合わせ。並び順は問わない）の数。dice_count個のダイスなら、重複組み合わせでC(dice_count + 5, 5)通りです。
+  inline auto hand_count(int dice_count) noexcept {
+    return binomial(dice_count + 5, 5);
+  }
+
+  // 手の番号（0〜hand_count(std::size(faces)) - 1）。ソートした目を(目 - 1 + i)の組み合わせに変換して、colex順の番号にします。
+  inline auto hand_index(const std::vector<int>& faces) noexcept {
+    auto sorted_faces = faces; std::sort(std::begin(sorted_faces), std::end(sorted_faces));
+
+    auto result = 0;
+
+    for (auto i = 0; i < static_cast<int>(std::size(sorted_faces)); ++i) {
+      result += binomial(sorted_faces[i] - 1 + i, i + 1);
+    }
+
+    return result;
+  }
+
+  // hand_index()の逆。手の番号から、ソートした目を求めます。
+  inline auto index_hand(int dice_count, int index) noexcept {
+    auto result = std::vector<int>(dice_count);
+
+    for (auto i = dice_count - 1; i >= 0; --i) {
+      auto combination = i + 5;
+
+      while (binomial(combination, i + 1) > index) {
+        --combination;
+      }
+
+      result[i] = combination - i + 1;
+      index -= binomial(combination, i + 1);
+    }
+
+    return result;
+  }
+
+  // Zobristハッシュのキー。乱数の表を持つ代わりに、種類と番号と値からmix_seedで作ります。
+  inline auto zobrist_key(int kind, int index, int value) noexcept {
+    return util::mix_seed(0x6c696172735f6469, static_cast<std::uint64_t>(kind) << 48 ^ static_cast<std::uint64_t>(index) << 24 ^ static_cast<std::uint32_t>(value));
+  }
+
   class game final {
     std::vector<player> _players;
     int _player_index;
+    int _max_bid_count;
+    std::array<int, 7> _face_counts;  // 目毎のダイスの数（0は隠された目）。face_countの度に全てのダイスを数えなくて済むように、作成時に数えておきます。
+    std::uint64_t _hash;              // 公開されている情報（ダイスの数と手）と、手番のプレイヤーの手のハッシュ。do_actionで差分更新します。
+
+    static auto count_faces(const std::vector<player>& players) noexcept {
+      auto result = std::array<int, 7>{};
+
+      for (const auto& player: players) {
+        for (const auto& face: player.faces()) {
+          if (face >= 0 && face <= 6) {
+            result[face]++;
+          }
+        }
+      }
+
+      return result;
+    }
+
+    // 手（目の組み合わせ）のハッシュ。並び順は問いません。隠された目は含めません。
+    static auto hand_hash(const std::vector<int>& faces) noexcept {
+      auto result = static_cast<std::uint64_t>(0);
+      auto counts = std::array<int, 7>{};
+
+      for (const auto& face: faces) {
+        if (face >= 1 && face <= 6) {
+          result ^= zobrist_key(1, face, counts[face]++);
+        }
+      }
+
+      return result;
+    }
+
+    // 宣言は番号が大きくなる順にしか打てないので、手の並び順を含めなくても履歴が区別できます。
+    static auto action_hash(int player_index, const action& action) noexcept {
+      return zobrist_key(2, player_index, action.bid() ? bid_index(action.bid().value()) : 0);
+    }
+
+    static auto initial_hash(const std::vector<player>& players, int player_index, int max_bid_count) noexcept {
+      auto result = zobrist_key(3, 0, max_bid_count);
+
+      for (auto i = 0; i < static_cast<int>(std::size(players)); ++i) {
+        result ^= zobrist_key(0, i, static_cast<int>(std::size(players[i].faces())));
+
+        for (const auto& action: players[i].actions()) {
+          result ^= action_hash(i, action);
+        }
+      }
+
+      return std::empty(players) ? result : result ^ hand_hash(players[player_index].faces());
+    }
 
   public:
-    game(const std::vector<player>& players, int player_index) noexcept: _players(players), _player_index(player_index) {
+    static constexpr auto default_max_bid_count = 20;
+
+    game(std::vector<player> players, int player_index, int max_bid_count) noexcept: _players(std::move(players)), _player_index(player_index), _max_bid_count(max_bid_count), _face_counts(count_faces(_players)), _hash(initial_hash(_players, player_index, max_bid_count)) {
       ;
     }
 
-    game(const std::vector<player>& players) noexcept: game(players, 0) {
+    game(std::vector<player> players, int player_index) noexcept: game(std::move(players), player_index, default_max_bid_count) {
       ;
     }
 
+    game(std::vector<player> players) noexcept: game(std::move(players), 0) {
+      ;
+    }
+
+    // ダイスの目を変更されるとface_countが狂ってしまうので、const版だけにしています。
     const auto& players() const noexcept {
       return _players;
     }
 
-    auto& players() noexcept {
-      return _players;
+    // プレイヤーをupdate_playersで書き換えて、作り直します。今のvectorの容量を使い回すので、JSONのデコードのように繰り返し作り直す場合でも、メモリを確保し直さずに済みます。
+    auto reset(const std::function<void(std::vector<player>&)>& update_players, int player_index, int max_bid_count) noexcept {
+      update_players(_players);
+
+      _player_index  = player_index;
+      _max_bid_count = max_bid_count;
+      _face_counts   = count_faces(_players);
+      _hash          = initial_hash(_players, player_index, max_bid_count);
     }
 
     const auto& player_index() const noexcept {
       return _player_index;
     }
 
+    // 手番のプレイヤーから見た情報集合のハッシュ。他のプレイヤーのダイスの目は含まないので、masked_game()でも同じ値になります。
+    const auto& hash() const noexcept {
+      return _hash;
+    }
+
+    // 宣言できる個数の上限。
+    const auto& max_bid_count() const noexcept {
+      return _max_bid_count;
+    }
+
     auto previous_player_index() const noexcept {
       return (player_index() + static_cast<int>(std::size(players())) - 1) % static_cast<int>(std::size(players()));
     }
 
     auto masked_game() const noexcept {
-      auto result = *this;
+      auto players = _players;
 
-      for (const auto& i: boost::irange(0, static_cast<int>(std::size(result.players())))) {
-        if (i != result.player_index()) {
-          result.players()[i].faces() = std::vector<int>(std::size(result.players()[i].faces()), 0);
+      for (const auto& i: boost::irange(0, static_cast<int>(std::size(players)))) {
+        if (i != player_index()) {
+          players[i].faces() = std::vector<int>(std::size(players[i].faces()), 0);
         }
       }
 
-      return result;
+      return game(std::move(players), player_index(), max_bid_count());
     }
 
-    auto face_count(int target_face) const noexcept {
-      auto result = 0;
+    // masked_game()の、resultに上書きする版。resultの容量を使い回すので、同じゲームの手番毎に呼んでも、メモリを確保し直しません。
+    auto masked_game(game& result) const noexcept {
+      result.reset(
+        [&](auto& players) {
+          players.resize(std::size(_players), player(std::string(), std::vector<int>()));
 
-      for (const auto& player: players()) {
-        for (const auto& face: player.faces()) {
-          if (face == target_face || face == 1) {
-            result++;
+          for (const auto& i: boost::irange(0, static_cast<int>(std::size(players)))) {
+            players[i].id() = _players[i].id();
+
+            if (i == player_index()) {
+              players[i].faces() = _players[i].faces();
+            } else {
+              players[i].faces().assign(std::size(_players[i].faces()), 0);
+            }
+
+            // コピー代入は要素数分しか確保しないので、手が増える度に確保し直さないように、元と同じ容量を確保しておきます。
+            players[i].actions().reserve(_players[i].actions().capacity());
+            players[i].actions() = _players[i].actions();
           }
-        }
+        },
+        player_index(),
+        max_bid_count());
+    }
+
+    auto face_count(int target_face) const noexcept {
+      if (target_face == 1) {
+        return _face_counts[1];
       }
 
-      return result;
+      return _face_counts[1] + (target_face >= 0 && target_face <= 6 ? _face_counts[target_face] : 0);
     }
 
     auto is_legal_action(const action& action) const noexcept {
@@ -163,7 +328,7 @@ namespace liars_dice {
           return false;
         }
 
-        if (bid.min_count() > 20) {
+        if (bid.min_count() > max_bid_count()) {
           return false;
         }
 
@@ -195,12 +360,17 @@ namespace liars_dice {
 
     auto do_action(const action& action) noexcept {
       _players[player_index()].actions().emplace_back(action);
+      _hash ^= action_hash(player_index(), action);
 
       if (action.challenge()) {
         return;
       }
 
+      _hash ^= hand_hash(players()[player_index()].faces());
+
 	  _player_index = (player_index() + 1) % std::size(players());
+
+      _hash ^= hand_hash(players()[player_index()].faces());
     }
 
     auto is_end() const noexcept {
@@ -235,44 +405,47 @@ namespace liars_dice {
     }
   };
 
-  inline auto play_game(const std::vector<std::string>& ids, const std::vector<int>& dice_counts, const std::vector<std::function<action(const game&)>>& action_functions) noexcept {
-    auto random_engine = std::mt19937_64(std::random_device()());
-
-    const auto& id_and_action_functions = boost::copy_range<std::unordered_map<std::string, std::function<action(const liars_dice::game&)>>>(
-      util::combine(ids, action_functions) |
-      boost::adaptors::transformed(
-        [&](const auto& id_and_action_function) {
-          const auto& [id, action_function] = id_and_action_function;
-
-          return std::make_pair(id, action_function);
-        }));
-
+  // ゲームを実行します。ダイスの目はseedと席の番号から作成するので、同じseedなら、他のプレイヤーのダイスの数が変わっても同じ目になります。
+  // プレイヤーは席の順なので、手番のプレイヤーの関数はaction_functions[player_index]です。手を打つ度にメモリを確保しないように、手の容量は最初に確保して、masked_gameは使い回します。
+  inline auto play_game(const std::vector<std::string>& ids, const std::vector<int>& dice_counts, const std::vector<std::function<action(const game&)>>& action_functions, std::uint64_t seed, int max_bid_count = game::default_max_bid_count) noexcept {
     auto game = [&]() {
-      const auto& players = boost::copy_range<std::vector<player>>(
+      auto players = boost::copy_range<std::vector<player>>(
         util::combine(ids, dice_counts) |
+        boost::adaptors::indexed() |
         boost::adaptors::transformed(
-          [&](const auto& id_and_dice_count) {
-            const auto&[id, dice_count] = id_and_dice_count;
+          [&](const auto& indexed_id_and_dice_count) {
+            const auto&[id, dice_count] = indexed_id_and_dice_count.value();
             const auto& faces = [&, dice_count = dice_count]() {  // P0588R1...
+              auto random_engine = util::portable_random_engine(util::mix_seed(seed, indexed_id_and_dice_count.index()));
+
               auto result = boost::copy_range<std::vector<int>>(
                 boost::irange(0, dice_count) |
-                boost::adaptors::transformed([&](const auto& _) { return std::uniform_int_distribution(1, 6)(random_engine); }));
+                boost::adaptors::transformed([&](const auto& _) { return 1 + static_cast<int>(random_engine.uniform(6)); }));
 
               boost::sort(result);
 
               return result;
             }();
 
-            return player(id, faces);
+            auto result = player(id, faces);
+
+            // 宣言は番号が大きくなる順にしか打てないので、1人の手の数は、宣言の種類の数を人数で割った数とチャレンジを足した数以下です。
+            result.actions().reserve(max_bid_count * 5 / std::size(ids) + 2);
+
+            return result;
           }));
 
-      return liars_dice::game(players);
+      return liars_dice::game(std::move(players), 0, max_bid_count);
     }();
 
+    auto masked_game = game;
+
     const auto& dice_count_deltas = [&]() {
       while (!game.is_end()) {
         try {
-          const auto& action = id_and_action_functions.at(game.players()[game.player_index()].id())(game.masked_game());
+          game.masked_game(masked_game);
+
+          const auto& action = action_functions.at(game.player_index())(masked_game);
 
           if (!game.is_legal_action(action)) {
             auto result = std::vector<int>(std::size(game.players()), 0);
@@ -296,6 +469,10 @@ namespace liars_dice {
       return game.dice_count_deltas();
     }();
 
-    return std::make_tuple(game, dice_count_deltas);
+    return std::make_tuple(std::move(game), dice_count_deltas);
+  }
+
+  inline auto play_game(const std::vector<std::string>& ids, const std::vector<int>& dice_counts, const std::vector<std::function<action(const game&)>>& action_functions) noexcept {
+    return play_game(ids, dice_counts, action_functions, std::random_device()());
   }
 }
@@ -0,0 +1,318 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "game.hpp"
+#include "json.hpp"
+
+namespace liars_dice {
+  // バイナリ形式のゲーム・ログ。all-games.jsonは全体をパースしないと1ゲームも読めないので、固定長に詰めた形式と、ゲーム毎のオフセットの索引を用意しました。
+  // 数値は全てリトル・エンディアンです。
+  //
+  // ヘッダー（32バイト）: "LDGAMES"、バージョン（1バイト）、文字列の数（4バイト）、ゲームの数（4バイト）、文字列表のオフセット（8バイト）、索引のオフセット（8バイト）
+  // ゲーム:              プレイヤーの数（2バイト）、手番（2バイト）、宣言の上限（2バイト）、予備（2バイト）、
+  //                      プレイヤー毎に{プログラムのパスの文字列番号（4バイト）、IDの文字列番号（4バイト）、ダイスの数（2バイト）、手の数（2バイト）}、
+  //                      全員分のダイスの目（4ビットずつ）、全員分の手（2バイトずつ。宣言は個数 * 8 + 目、チャレンジは0xffff）
+  // 文字列表:            文字列毎に{長さ（4バイト）、UTF-8のバイト列}
+  // 索引:                ゲーム毎のオフセット（8バイトずつ）
+
+  constexpr auto game_log_magic           = "LDGAMES";
+  constexpr auto game_log_version         = 1;
+  constexpr auto game_log_header_size     = 32;
+  constexpr auto game_log_no_string_index = static_cast<std::uint32_t>(0xffffffff);
+  constexpr auto game_log_challenge       = static_cast<std::uint16_t>(0xffff);
+  constexpr auto game_log_max_uint16      = 0xffff;
+  constexpr auto game_log_max_bid_count   = (game_log_challenge - 1 - 6) / 8;  // 宣言（個数 * 8 + 目）がチャレンジの値と重ならない、最大の個数。
+
+  inline auto put_uint(std::string& buffer, std::uint64_t value, int byte_count) noexcept {
+    for (auto i = 0; i < byte_count; ++i) {
+      buffer.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+    }
+  }
+
+  // 固定長のフィールドに収まらない値を書くと、黙って壊れたログになってしまうので、例外にします。
+  inline auto put_checked_uint(std::string& buffer, std::uint64_t value, int byte_count, const char* name) {
+    if (byte_count < 8 && value >> (byte_count * 8) != 0) {
+      throw std::out_of_range(std::string("too large for the game log: ") + name + " = " + std::to_string(value));
+    }
+
+    put_uint(buffer, value, byte_count);
+  }
+
+  inline auto put_action(std::string& buffer, const action& action) {
+    if (action.bid() && action.bid()->min_count() > game_log_max_bid_count) {
+      throw std::out_of_range("too large for the game log: bid count = " + std::to_string(action.bid()->min_count()));
+    }
+
+    put_uint(buffer, action.bid() ? action.bid()->min_count() * 8 + action.bid()->face() : game_log_challenge, 2);
+  }
+
+  inline auto get_uint(const char* data, int byte_count) noexcept {
+    auto result = static_cast<std::uint64_t>(0);
+
+    for (auto i = 0; i < byte_count; ++i) {
+      result |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[i])) << (i * 8);
+    }
+
+    return result;
+  }
+
+  // object -> binary
+
+  inline auto write_game_log(const std::vector<std::tuple<std::unordered_map<std::string, std::string>, game>>& past_games) {
+    auto strings        = std::vector<std::string>();
+    auto string_indices = std::unordered_map<std::string, std::uint32_t>();
+
+    const auto& string_index = [&](const std::string& string) {
+      const auto& [it, is_inserted] = string_indices.emplace(string, static_cast<std::uint32_t>(std::size(strings)));
+
+      if (is_inserted) {
+        strings.emplace_back(string);
+      }
+
+      return it->second;
+    };
+
+    auto body    = std::string();
+    auto offsets = std::vector<std::uint64_t>(); offsets.reserve(std::size(past_games));
+
+    for (const auto& [program_path_and_program_ids, game]: past_games) {
+      offsets.emplace_back(game_log_header_size + std::size(body));
+
+      // 記録されているのはプログラムのパスからIDへの対応なので、逆引きできるようにします。
+      const auto& program_id_and_program_paths = [&, &program_path_and_program_ids = program_path_and_program_ids]() {  // P0588R1...
+        auto result = std::unordered_map<std::string, std::string>();
+
+        for (const auto& [program_path, program_id]: program_path_and_program_ids) {
+          result.emplace(program_id, program_path);
+        }
+
+        return result;
+      }();
+
+      put_checked_uint(body, std::size(game.players()), 2, "player count");
+      put_checked_uint(body, game.player_index(), 2, "player index");
+      put_checked_uint(body, game.max_bid_count(), 2, "max bid count");
+      put_uint(body, 0, 2);
+
+      for (const auto& player: game.players()) {
+        const auto& it = program_id_and_program_paths.find(player.id());
+
+        put_uint(body, it != std::end(program_id_and_program_paths) ? string_index(it->second) : game_log_no_string_index, 4);
+        put_uint(body, string_index(player.id()), 4);
+        put_checked_uint(body, std::size(player.faces()), 2, "dice count");
+        put_checked_uint(body, std::size(player.actions()), 2, "action count");
+      }
+
+      [&, &game = game]() {  // P0588R1...
+        auto nibble_count = 0;
+
+        for (const auto& player: game.players()) {
+          for (const auto& face: player.faces()) {
+            if (nibble_count % 2 == 0) {
+              body.push_back(static_cast<char>(face & 0x0f));
+            } else {
+              body.back() = static_cast<char>(body.back() | (face & 0x0f) << 4);
+            }
+
+            nibble_count++;
+          }
+        }
+      }();
+
+      for (const auto& player: game.players()) {
+        for (const auto& action: player.actions()) {
+          put_action(body, action);
+        }
+      }
+    }
+
+    const auto& string_table = [&]() {
+      auto result = std::string();
+
+      for (const auto& string: strings) {
+        put_uint(result, std::size(string), 4);
+        result.append(string);
+      }
+
+      return result;
+    }();
+
+    auto result = std::string(game_log_magic);
+
+    result.push_back(static_cast<char>(game_log_version));
+    put_uint(result, std::size(strings), 4);
+    put_uint(result, std::size(past_games), 4);
+    put_uint(result, game_log_header_size + std::size(body), 8);
+    put_uint(result, game_log_header_size + std::size(body) + std::size(string_table), 8);
+
+    result.append(body);
+    result.append(string_table);
+
+    for (const auto& offset: offsets) {
+      put_uint(result, offset, 8);
+    }
+
+    return result;
+  }
+
+  // binary -> object
+
+  // ファイルをメモリにマップして、必要なゲームだけを読み込みます。
+  class game_log final {
+    boost::interprocess::file_mapping _file_mapping;
+    boost::interprocess::mapped_region _mapped_region;
+    const char* _data;
+    int _game_count;
+    std::uint64_t _index_offset;
+    std::vector<std::string> _strings;
+
+  public:
+    game_log(const std::string& path_string): _file_mapping(path_string.c_str(), boost::interprocess::read_only), _mapped_region(_file_mapping, boost::interprocess::read_only), _data(static_cast<const char*>(_mapped_region.get_address())) {
+      if (_mapped_region.get_size() < game_log_header_size || std::string(_data, 7) != game_log_magic || _data[7] != game_log_version) {
+        throw std::runtime_error("not a game log: " + path_string);
+      }
+
+      _game_count   = static_cast<int>(get_uint(_data + 12, 4));
+      _index_offset = get_uint(_data + 24, 8);
+
+      const auto& string_count = static_cast<int>(get_uint(_data + 8, 4));
+
+      _strings.reserve(string_count);
+
+      auto p = _data + get_uint(_data + 16, 8);
+
+      for (auto i = 0; i < string_count; ++i) {
+        const auto& length = static_cast<std::size_t>(get_uint(p, 4));
+
+        _strings.emplace_back(p + 4, length);
+
+        p += 4 + length;
+      }
+    }
+
+    auto size() const noexcept {
+      return _game_count;
+    }
+
+    auto past_game(int index) const noexcept {
+      const auto* p = _data + get_uint(_data + _index_offset + index * 8, 8);
+
+      const auto& player_count  = static_cast<int>(get_uint(p + 0, 2));
+      const auto& player_index  = static_cast<int>(get_uint(p + 2, 2));
+      const auto& max_bid_count = static_cast<int>(get_uint(p + 4, 2));
+
+      p += 8;
+
+      auto program_path_and_program_ids = std::unordered_map<std::string, std::string>();
+
+      auto ids           = std::vector<std::string>(); ids.reserve(player_count);
+      auto dice_counts   = std::vector<int>();         dice_counts.reserve(player_count);
+      auto action_counts = std::vector<int>();         action_counts.reserve(player_count);
+
+      for (auto i = 0; i < player_count; ++i) {
+        const auto& program_path_index = static_cast<std::uint32_t>(get_uint(p, 4));
+
+        ids.emplace_back(_strings[get_uint(p + 4, 4)]);
+        dice_counts.emplace_back(static_cast<int>(get_uint(p + 8, 2)));
+        action_counts.emplace_back(static_cast<int>(get_uint(p + 10, 2)));
+
+        if (program_path_index != game_log_no_string_index) {
+          program_path_and_program_ids.emplace(_strings[program_path_index], ids.back());
+        }
+
+        p += 12;
+      }
+
+      auto nibble_index = 0;
+
+      const auto& faces_collection = boost::copy_range<std::vector<std::vector<int>>>(
+        dice_counts |
+        boost::adaptors::transformed(
+          [&](const auto& dice_count) {
+            auto result = std::vector<int>(); result.reserve(dice_count);
+
+            for (auto i = 0; i < dice_count; ++i, ++nibble_index) {
+              result.emplace_back((static_cast<unsigned char>(p[nibble_index / 2]) >> (nibble_index % 2 * 4)) & 0x0f);
+            }
+
+            return result;
+          }));
+
+      p += (nibble_index + 1) / 2;
+
+      auto players = std::vector<player>(); players.reserve(player_count);
+
+      for (auto i = 0; i < player_count; ++i) {
+        auto actions = std::vector<action>(); actions.reserve(action_counts[i]);
+
+        for (auto j = 0; j < action_counts[i]; ++j, p += 2) {
+          const auto& value = static_cast<int>(get_uint(p, 2));
+
+          actions.emplace_back(value == game_log_challenge ? action(challenge()) : action(bid(value % 8, value / 8)));
+        }
+
+        players.emplace_back(ids[i], faces_collection[i], actions);
+      }
+
+      return std::make_tuple(program_path_and_program_ids, game(players, player_index, max_bid_count));
+    }
+
+    auto past_games() const noexcept {
+      auto result = std::vector<std::tuple<std::unordered_map<std::string, std::string>, game>>(); result.reserve(size());
+
+      for (auto i = 0; i < size(); ++i) {
+        result.emplace_back(past_game(i));
+      }
+
+      return result;
+    }
+  };
+
+  // file
+
+  inline auto is_game_log_file(const std::string& path_string) {
+    auto ifstream = std::ifstream(path_string, std::ios::binary);
+    auto magic = std::string(7, '\0');
+
+    return static_cast<bool>(ifstream.read(std::data(magic), 7)) && magic == game_log_magic;
+  }
+
+  // バイナリ形式でもJSON形式でも読み込めます。
+  inline auto read_past_games_file(const std::string& path_string) {
+    if (is_game_log_file(path_string)) {
+      return game_log(path_string).past_games();
+    }
+
+    auto ifstream = std::ifstream(path_string);
+    auto stream = std::stringstream(); stream << ifstream.rdbuf();
+
+    return read_json(stream.str(), std::function(read_past_games));
+  }
+
+  // 拡張子が.binならバイナリ形式で、そうでなければJSON形式で書き込みます。
+  inline auto write_past_games_file(const std::string& path_string, const std::vector<std::tuple<std::unordered_map<std::string, std::string>, game>>& past_games) {
+    const auto& is_binary = std::size(path_string) >= 4 && path_string.compare(std::size(path_string) - 4, 4, ".bin") == 0;
+
+    auto ofstream = std::ofstream(path_string, is_binary ? std::ios::out | std::ios::binary : std::ios::out);
+    ofstream << (is_binary ? write_game_log(past_games) : write_json(past_games, std::function(write_past_games)));
+    ofstream.close();
+  }
+}
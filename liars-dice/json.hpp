@@ -1,13 +1,19 @@
 ﻿#pragma once
 
 #include <functional>
+#include <optional>
+#include <ostream>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #ifdef _MSC_VER
 #pragma warning(push, 0)
 #endif
+#include <rapidjson/allocators.h>
 #include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 #ifdef _MSC_VER
 #pragma warning(pop)
@@ -82,6 +88,11 @@ namespace liars_dice {
     writer.EndArray();
     writer.Key("player_index");
     writer.Int(game.player_index());
+    // 既定値の場合は書きません。配布しているJavaのプログラムなどは、知らないキーがあるとパースに失敗するので。
+    if (game.max_bid_count() != game::default_max_bid_count) {
+      writer.Key("max_bid_count");
+      writer.Int(game.max_bid_count());
+    }
     writer.EndObject();
   }
 
@@ -115,36 +126,61 @@ namespace liars_dice {
     writer.EndArray();
   }
 
-  inline auto write_past_games(const std::vector<std::tuple<std::unordered_map<std::string, std::string>, game>>& past_games, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+  inline auto write_past_game(const std::tuple<std::unordered_map<std::string, std::string>, game>& past_game, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    const auto& [program_path_and_program_ids, game] = past_game;
+
+    writer.StartObject();
+    writer.Key("programs");
     writer.StartArray();
-    for (const auto& [program_path_and_program_ids, game]: past_games) {
+    for (const auto& [program_path, program_id]: program_path_and_program_ids) {
       writer.StartObject();
-      writer.Key("programs");
-      writer.StartArray();
-      for (const auto& [program_path, program_id]: program_path_and_program_ids) {
-        writer.StartObject();
-        writer.Key("path");
-        writer.String(program_path.c_str());
-        writer.Key("id");
-        writer.String(program_id.c_str());
-        writer.EndObject();
-      }
-      writer.EndArray();
-      writer.Key("game");
-      write_game(game, writer);
+      writer.Key("path");
+      writer.String(program_path.c_str());
+      writer.Key("id");
+      writer.String(program_id.c_str());
       writer.EndObject();
     }
     writer.EndArray();
+    writer.Key("game");
+    write_game(game, writer);
+    writer.EndObject();
+  }
+
+  inline auto write_past_games(const std::vector<std::tuple<std::unordered_map<std::string, std::string>, game>>& past_games, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartArray();
+    for (const auto& past_game: past_games) {
+      write_past_game(past_game, writer);
+    }
+    writer.EndArray();
   }
 
+  // バッファーとWriterの内部のスタックを確保し直さないように、スレッド毎に使い回します。write_tの中でwrite_jsonを呼ばないでください。
   template<class T>
-  inline auto write_json(const T& t, const std::function<void(const T&, rapidjson::Writer<rapidjson::StringBuffer>&)>& write_t) noexcept {
-    auto string_buffer = rapidjson::StringBuffer();
-    auto writer = rapidjson::Writer<rapidjson::StringBuffer>(string_buffer);
+  inline auto write_json_buffer(const T& t, const std::function<void(const T&, rapidjson::Writer<rapidjson::StringBuffer>&)>& write_t) noexcept -> const rapidjson::StringBuffer& {
+    thread_local auto string_buffer = rapidjson::StringBuffer();
+    thread_local auto writer = rapidjson::Writer<rapidjson::StringBuffer>(string_buffer);
+
+    string_buffer.Clear();
+    writer.Reset(string_buffer);
 
     write_t(t, writer);
 
-    return std::string(string_buffer.GetString());
+    return string_buffer;
+  }
+
+  template<class T>
+  inline auto write_json(const T& t, const std::function<void(const T&, rapidjson::Writer<rapidjson::StringBuffer>&)>& write_t) noexcept {
+    const auto& string_buffer = write_json_buffer(t, write_t);
+
+    return std::string(string_buffer.GetString(), string_buffer.GetSize());
+  }
+
+  // std::stringを作らずに、直接ostreamに書き込みます。
+  template<class T>
+  inline auto write_json(std::ostream& ostream, const T& t, const std::function<void(const T&, rapidjson::Writer<rapidjson::StringBuffer>&)>& write_t) noexcept {
+    const auto& string_buffer = write_json_buffer(t, write_t);
+
+    ostream.write(string_buffer.GetString(), string_buffer.GetSize());
   }
 
   // json -> object
@@ -176,33 +212,54 @@ namespace liars_dice {
     throw std::exception();
   }
 
-  inline auto read_player(const rapidjson::Value& value) noexcept {
-    const auto& id = value["id"].GetString();
-    const auto& faces = [&]() {
-      auto result = std::vector<int>();
+  // resultに上書きします。resultのvectorの容量を使い回すので、同じプレイヤーで繰り返し呼べば、メモリを確保し直しません。
+  inline auto read_player_in_place(const rapidjson::Value& value, player& result) noexcept {
+    result.id().assign(value["id"].GetString(), value["id"].GetStringLength());
 
-      for (auto it = value["faces"].Begin(); it != value["faces"].End(); ++it) {
-        result.emplace_back(it->GetInt());
-      }
+    result.faces().clear();
 
-      return result;
-    }();
-    const auto& actions = [&]() {
-      auto result = std::vector<action>();
+    for (auto it = value["faces"].Begin(); it != value["faces"].End(); ++it) {
+      result.faces().emplace_back(it->GetInt());
+    }
 
-      for (auto it = value["actions"].Begin(); it != value["actions"].End(); ++it) {
-        result.emplace_back(read_action(*it));
-      }
+    result.actions().clear();
 
-      return result;
-    }();
+    for (auto it = value["actions"].Begin(); it != value["actions"].End(); ++it) {
+      result.actions().emplace_back(read_action(*it));
+    }
+  }
 
-    return player(id, faces, actions);
+  inline auto read_player(const rapidjson::Value& value) noexcept {
+    auto result = player(std::string(), std::vector<int>());
+
+    result.faces().reserve(value["faces"].Size());
+    result.actions().reserve(value["actions"].Size());
+
+    read_player_in_place(value, result);
+
+    return result;
+  }
+
+  // resultに上書きします。プログラムが手番毎にゲームを受け取る場合に、メモリを確保し直さずにデコードするために使用します。
+  inline auto read_game_in_place(const rapidjson::Value& value, game& result) noexcept {
+    const auto& player_index = value["player_index"].GetInt();
+    const auto& max_bid_count = value.HasMember("max_bid_count") ? value["max_bid_count"].GetInt() : game::default_max_bid_count;  // 既定値の場合は書かないので（古いall-games.jsonにも無いので）。
+
+    result.reset(
+      [&](auto& players) {
+        players.resize(value["players"].Size(), player(std::string(), std::vector<int>()));
+
+        for (auto i = static_cast<rapidjson::SizeType>(0); i < value["players"].Size(); ++i) {
+          read_player_in_place(value["players"][i], players[i]);
+        }
+      },
+      player_index,
+      max_bid_count);
   }
 
   inline auto read_game(const rapidjson::Value& value) noexcept {
-    const auto& players = [&]() {
-      auto result = std::vector<player>();
+    auto players = [&]() {
+      auto result = std::vector<player>(); result.reserve(value["players"].Size());
 
       for (auto it = value["players"].Begin(); it != value["players"].End(); ++it) {
         result.emplace_back(read_player(*it));
@@ -211,21 +268,21 @@ namespace liars_dice {
       return result;
     }();
     const auto& player_index = value["player_index"].GetInt();
+    const auto& max_bid_count = value.HasMember("max_bid_count") ? value["max_bid_count"].GetInt() : game::default_max_bid_count;  // 既定値の場合は書かないので（古いall-games.jsonにも無いので）。
 
-    return game(players, player_index);
+    return game(std::move(players), player_index, max_bid_count);
   }
 
   inline auto read_career_record(const rapidjson::Value& value) noexcept {
     const auto& id = value["id"].GetString();
-    const auto& game = read_game(value["game"]);
 
-    return career_record{id, game};
+    return career_record{id, read_game(value["game"])};
   }
 
   inline auto read_career(const rapidjson::Value& value) noexcept {
     const auto& id = value["id"].GetString();
-    const auto& career_records = [&]() {
-      auto result = std::vector<career_record>();
+    auto career_records = [&]() {
+      auto result = std::vector<career_record>(); result.reserve(value["career_records"].Size());
 
       for (auto it = value["career_records"].Begin(); it != value["career_records"].End(); ++it) {
         result.emplace_back(read_career_record(*it));
@@ -234,11 +291,11 @@ namespace liars_dice {
       return result;
     }();
 
-    return career{id, career_records};
+    return career{id, std::move(career_records)};
   }
 
   inline auto read_careers(const rapidjson::Value& value) noexcept {
-    auto result = std::vector<career>();
+    auto result = std::vector<career>(); result.reserve(value.Size());
 
     for (auto it = value.Begin(); it != value.End(); ++it) {
       result.emplace_back(read_career(*it));
@@ -247,12 +304,66 @@ namespace liars_dice {
     return result;
   }
 
+  inline auto read_past_game(const rapidjson::Value& value) noexcept {
+    auto program_path_and_program_ids = [&]() {
+      auto result = std::unordered_map<std::string, std::string>();
+
+      for (auto it = value["programs"].Begin(); it != value["programs"].End(); ++it) {
+        result.emplace((*it)["path"].GetString(), (*it)["id"].GetString());
+      }
+
+      return result;
+    }();
+
+    return std::make_tuple(std::move(program_path_and_program_ids), read_game(value["game"]));
+  }
+
+  inline auto read_past_games(const rapidjson::Value& value) noexcept {
+    auto result = std::vector<std::tuple<std::unordered_map<std::string, std::string>, game>>(); result.reserve(value.Size());
+
+    for (auto it = value.Begin(); it != value.End(); ++it) {
+      result.emplace_back(read_past_game(*it));
+    }
+
+    return result;
+  }
+
+  // パースに使うアリーナ。rapidjsonのDocumentは、既定ではパースの度にメモリ・プールとパース用のスタックを確保し直すので、スレッド毎のバッファーの上に両方を作って、パースの度にリセットして使い回します。
+  // バッファーに収まらない大きなJSON（check_other_programsの戦歴など）の場合だけ、溢れた分を確保して、次のパースの前に解放します。
+  constexpr auto json_arena_size       = static_cast<std::size_t>(256 * 1024);
+  constexpr auto json_stack_arena_size = static_cast<std::size_t>( 64 * 1024);
+
+  using json_document = rapidjson::GenericDocument<rapidjson::UTF8<>, rapidjson::MemoryPoolAllocator<>, rapidjson::MemoryPoolAllocator<>>;
+
+  // read_tの中でread_jsonを呼ばないでください。アリーナがリセットされて、外側のドキュメントが壊れてしまいます。
+  inline auto parse_json(const std::string& json, const std::function<void(const rapidjson::Value& value)>& read) noexcept {
+    thread_local auto value_buffer = std::vector<char>(json_arena_size);
+    thread_local auto stack_buffer = std::vector<char>(json_stack_arena_size);
+    thread_local auto value_allocator = rapidjson::MemoryPoolAllocator<>(std::data(value_buffer), std::size(value_buffer));
+    thread_local auto stack_allocator = rapidjson::MemoryPoolAllocator<>(std::data(stack_buffer), std::size(stack_buffer));
+
+    value_allocator.Clear();
+    stack_allocator.Clear();
+
+    auto document = json_document(&value_allocator, 1024, &stack_allocator);  // スタックの初期容量はrapidjsonの既定値と同じ。
+
+    document.Parse(json.c_str());
+
+    read(document);
+  }
+
   template<class T>
   inline auto read_json(const std::string& json, const std::function<T(const rapidjson::Value& value)>& read_t) noexcept {
-    auto document = rapidjson::Document();
+    auto result = std::optional<T>();
 
-    document.Parse(json.c_str());
+    parse_json(json, [&](const auto& value) { result.emplace(read_t(value)); });
+
+    return std::move(result.value());
+  }
 
-    return read_t(document);
+  // tに上書きします。read_game_in_placeのように、tの容量を使い回す関数と組み合わせて使用します。
+  template<class T>
+  inline auto read_json(const std::string& json, T& t, const std::function<void(const rapidjson::Value& value, T& t)>& read_t) noexcept {
+    parse_json(json, [&](const auto& value) { read_t(value, t); });
   }
 }
@@ -1,5 +1,8 @@
 ﻿#include <iomanip>
 #include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -15,15 +18,178 @@
 #endif
 
 #include "dealer.hpp"
+#include "proxy_benchmark.hpp"
 #include "util.hpp"
 
 int main(int argc, char** argv) {
-  if (argc != 2) {
-    std::cerr << "usage: liars-dice min-set-count-per-player" << std::endl;
-    std::exit(1);
-  }
+  auto is_benchmark = false;  // --benchmarkが指定された場合は、選手権ではなく通信の計測をします。その場合、引数の数値はメッセージの数になります。
+
+  const auto& options = [&]() {
+    const auto& usage = [&]() {
+      std::cerr << "usage: liars-dice [--statistics statistics-path] [--metrics metrics-path] [--seed seed] [--shard index/count] [--games games-path] [--result result-path] [--checkpoint checkpoint-path] [--stop-confidence confidence] [--duplicate] [--career-summaries] [--career-map career-map-path] [--rules rules-path] [--table-size n] [--dice-count n] [--max-bid-count n] min-set-count-per-player" << std::endl;
+      std::cerr << "       liars-dice [--statistics statistics-path] [--metrics metrics-path] [--games games-path] [--result result-path] [--career-summaries] [--career-map career-map-path] --checkpoint checkpoint-path --resume" << std::endl;
+      std::cerr << "       liars-dice --benchmark [--statistics result-path] message-count-per-payload" << std::endl;
+      std::exit(1);
+    };
+
+    auto result = liars_dice::championship_options();
+    auto min_set_count = std::optional<int>();
+    auto is_resume = false;  // --resumeが指定された場合は、種やシャード、セット数、ルール、重複（duplicate）モードかどうかは途中経過のものを使用します。
+
+    // 種を指定しない場合は、毎回違う種にします。再現したい場合は、出力された種を--seedで指定してください。
+    result.seed = static_cast<std::uint64_t>(std::random_device()()) << 32 | std::random_device()();
+
+    for (auto i = 1; i < argc; ++i) {
+      const auto& arg = std::string(argv[i]);
+
+      if (arg == "--statistics" && i + 1 < argc) {
+        result.statistics_path_string = argv[++i];
+        continue;
+      }
+
+      if (arg == "--metrics" && i + 1 < argc) {
+        result.metrics_path_string = argv[++i];
+        continue;
+      }
+
+      if (arg == "--seed" && i + 1 < argc) {
+        result.seed = std::stoull(argv[++i]);
+        continue;
+      }
+
+      if (arg == "--shard" && i + 1 < argc) {
+        const auto& shard = std::string(argv[++i]);
+        const auto& slash_position = shard.find('/');
+
+        if (slash_position == std::string::npos) {
+          usage();
+        }
+
+        result.shard_index = std::stoi(shard.substr(0, slash_position));
+        result.shard_count = std::stoi(shard.substr(slash_position + 1));
+
+        if (result.shard_count < 1 || result.shard_index < 0 || result.shard_index >= result.shard_count) {
+          usage();
+        }
+
+        continue;
+      }
+
+      if (arg == "--games" && i + 1 < argc) {
+        result.games_path_string = argv[++i];
+        continue;
+      }
+
+      if (arg == "--result" && i + 1 < argc) {
+        result.result_path_string = argv[++i];
+        continue;
+      }
+
+      if (arg == "--checkpoint" && i + 1 < argc) {
+        result.checkpoint_path_string = argv[++i];
+        continue;
+      }
+
+      if (arg == "--stop-confidence" && i + 1 < argc) {
+        result.stop_confidence = std::stod(argv[++i]);
+
+        // 順位が確定する確率なので、0.5以下だと最初から確定してしまいますし、1だと決して確定しません。
+        if (!(result.stop_confidence.value() > 0.5 && result.stop_confidence.value() < 1)) {
+          usage();
+        }
+
+        continue;
+      }
+
+      // ルールは、設定ファイル（{"table_size": 6, "dice_count": 5, "max_bid_count": 20}のようなJSON）でも、個別のオプションでも指定できます。後に書いた方が優先です。
+      if (arg == "--rules" && i + 1 < argc) {
+        result.rules = liars_dice::read_rules_file(argv[++i]);
+        continue;
+      }
+
+      if (arg == "--table-size" && i + 1 < argc) {
+        result.rules.table_size = std::stoi(argv[++i]);
+        continue;
+      }
+
+      if (arg == "--dice-count" && i + 1 < argc) {
+        result.rules.dice_count = std::stoi(argv[++i]);
+        continue;
+      }
+
+      if (arg == "--max-bid-count" && i + 1 < argc) {
+        result.rules.max_bid_count = std::stoi(argv[++i]);
+        continue;
+      }
 
-  const auto& min_set_count = std::stoi(argv[1]);
+      if (arg == "--duplicate") {
+        result.is_duplicate = true;
+        continue;
+      }
+
+      if (arg == "--career-summaries") {
+        result.sends_career_summaries = true;
+        continue;
+      }
+
+      if (arg == "--career-map" && i + 1 < argc) {
+        result.career_map_path_string = argv[++i];
+        continue;
+      }
+
+      if (arg == "--resume") {
+        is_resume = true;
+        continue;
+      }
+
+      if (arg == "--benchmark") {
+        is_benchmark = true;
+        continue;
+      }
+
+      if (arg.rfind("--", 0) == 0 || min_set_count) {
+        usage();
+      }
+
+      min_set_count = std::stoi(arg);
+    }
+
+    if (is_resume) {
+      if (!result.checkpoint_path_string || min_set_count || !boost::filesystem::exists(result.checkpoint_path_string.value())) {
+        usage();
+      }
+
+      try {
+        result.resumed_checkpoint = liars_dice::read_championship_checkpoint_file(result.checkpoint_path_string.value());
+      } catch (const std::exception& exception) {
+        std::cerr << "*** CANNOT READ CHECKPOINT from " << result.checkpoint_path_string.value() << ": " << exception.what() << " ***" << std::endl;
+        std::exit(1);
+      }
+
+      result.seed            = result.resumed_checkpoint->result.seed;
+      result.shard_index     = result.resumed_checkpoint->result.shard_index;
+      result.shard_count     = result.resumed_checkpoint->result.shard_count;
+      result.min_set_count   = result.resumed_checkpoint->result.min_set_count;
+      result.rules           = result.resumed_checkpoint->result.rules;
+      result.stop_confidence = result.resumed_checkpoint->stop_confidence;
+      result.is_duplicate    = result.resumed_checkpoint->result.is_duplicate;
+
+      return result;
+    }
+
+    if (!min_set_count) {
+      usage();
+    }
+
+    result.min_set_count = min_set_count.value();
+
+    // 上限は、バイナリのゲーム・ログや戦歴のファイルの固定長のフィールドに収まる値です。
+    if (result.rules.table_size < 2 || result.rules.table_size > liars_dice::game_log_max_uint16 || result.rules.dice_count < 1 || result.rules.dice_count > liars_dice::game_log_max_uint16 || result.rules.max_bid_count < 1 || result.rules.max_bid_count > liars_dice::game_log_max_bid_count) {
+      usage();
+    }
+
+    return result;
+  }();
 
   const auto& program_path_strings = []() {
     auto result = boost::copy_range<std::vector<std::string>>(
@@ -47,7 +213,25 @@ int main(int argc, char** argv) {
     return result;
   }();
 
-  liars_dice::play_championship(program_path_strings, min_set_count);
+  if (is_benchmark) {
+    liars_dice::run_proxy_benchmarks(program_path_strings, options.min_set_count, options.statistics_path_string);
+
+    return 0;
+  }
+
+  // 途中経過と参加プログラムが違う場合は、セットの組み合わせが変わってしまうので再開できません。
+  if (options.resumed_checkpoint) {
+    const auto& checkpoint_program_path_strings = boost::copy_range<std::vector<std::string>>(
+      options.resumed_checkpoint->result.program_evaluations |
+      boost::adaptors::transformed([](const auto& program_path_and_program_evaluation) { return std::get<0>(program_path_and_program_evaluation); }));
+
+    if (checkpoint_program_path_strings != program_path_strings) {
+      std::cerr << "*** PROGRAMS ARE DIFFERENT FROM THE CHECKPOINT ***" << std::endl;
+      std::exit(1);
+    }
+  }
+
+  liars_dice::play_championship(program_path_strings, options);
 
   return 0;
 }
@@ -0,0 +1,140 @@
+﻿#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/range/adaptors.hpp>
+#include <boost/range/algorithm.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "../championship_result.hpp"
+#include "../dealer.hpp"
+#include "../game.hpp"
+#include "../game_log.hpp"
+#include "../json.hpp"
+
+// liars-dice --shard i/n --result ... --games ...で手分けして実行した結果を、ひとつにまとめます。
+// 全てのシャードが同じ種とシャード数で実行されていて、シャードの番号に重複や抜けがないことを確認します。
+
+inline auto read_file(const std::string& path_string) {
+  auto ifstream = std::ifstream(path_string);
+  auto stream = std::stringstream(); stream << ifstream.rdbuf();
+
+  return stream.str();
+}
+
+int main(int argc, char** argv) {
+  if (argc < 5 || argc % 2 != 1) {
+    std::cerr << "usage: liars-dice-merge merged-result-path merged-games-path shard-result-path shard-games-path [shard-result-path shard-games-path ...]" << std::endl;
+    std::exit(1);
+  }
+
+  auto championship_results = std::vector<liars_dice::championship_result>();
+  auto past_games = std::vector<std::tuple<std::unordered_map<std::string, std::string>, liars_dice::game>>();
+
+  for (auto i = 3; i < argc; i += 2) {
+    championship_results.emplace_back(liars_dice::read_json(read_file(argv[i]), std::function(liars_dice::read_championship_result)));
+
+    for (const auto& past_game: liars_dice::read_past_games_file(argv[i + 1])) {
+      past_games.emplace_back(past_game);
+    }
+  }
+
+  // 同じ選手権のシャードが、全て揃っているかを確認します。プログラムが違うと、同じ種でもセットの組み合わせが変わってしまうので、プログラムの一覧も比較します。
+  // 重複（duplicate）モードとそうでないモードでは、スコアの意味が違うので混ぜられません。
+  [&]() {
+    const auto& first = championship_results.front();
+
+    const auto& program_paths = [](const auto& championship_result) {
+      auto result = boost::copy_range<std::vector<std::string>>(
+        championship_result.program_evaluations |
+        boost::adaptors::transformed([](const auto& program_path_and_program_evaluation) { return std::get<0>(program_path_and_program_evaluation); }));
+
+      boost::sort(result);
+
+      return result;
+    };
+
+    auto shard_indices = std::vector<int>();
+
+    for (const auto& championship_result: championship_results) {
+      if (championship_result.seed != first.seed || championship_result.shard_count != first.shard_count || championship_result.min_set_count != first.min_set_count || championship_result.rules != first.rules || championship_result.is_duplicate != first.is_duplicate || program_paths(championship_result) != program_paths(first)) {
+        std::cerr << "*** SHARDS OF DIFFERENT CHAMPIONSHIPS ***" << std::endl;
+        std::exit(1);
+      }
+
+      shard_indices.emplace_back(championship_result.shard_index);
+    }
+
+    boost::sort(shard_indices);
+
+    if (shard_indices != boost::copy_range<std::vector<int>>(boost::irange(0, first.shard_count))) {
+      std::cerr << "*** MISSING OR DUPLICATED SHARDS ***" << std::endl;
+      std::exit(1);
+    }
+  }();
+
+  // プログラム毎に、スコアの合計とセット数を足し合わせます。
+  const auto& merged_result = [&]() {
+    const auto& first = championship_results.front();
+
+    auto program_paths = std::vector<std::string>();
+    auto program_evaluations = std::unordered_map<std::string, liars_dice::program_evaluation>();
+
+    for (const auto& championship_result: championship_results) {
+      for (const auto& [program_path, program_evaluation]: championship_result.program_evaluations) {
+        if (!program_evaluations.count(program_path)) {
+          program_paths.emplace_back(program_path);
+        }
+
+        program_evaluations[program_path].merge(program_evaluation);
+      }
+    }
+
+    return liars_dice::championship_result{
+      first.seed,
+      0,
+      1,
+      first.min_set_count,
+      first.rules,
+      first.is_duplicate,
+      boost::copy_range<std::vector<std::tuple<std::string, liars_dice::program_evaluation>>>(
+        program_paths |
+        boost::adaptors::transformed([&](const auto& program_path) { return std::make_tuple(program_path, program_evaluations.at(program_path)); }))};
+  }();
+
+  [&]() {
+    const auto& program_paths = boost::copy_range<std::vector<std::string>>(
+      merged_result.program_evaluations |
+      boost::adaptors::transformed([](const auto& program_path_and_program_evaluation) { return std::get<0>(program_path_and_program_evaluation); }));
+
+    const auto& scores = boost::copy_range<std::vector<float>>(
+      merged_result.program_evaluations |
+      boost::adaptors::transformed([](const auto& program_path_and_program_evaluation) { return std::get<1>(program_path_and_program_evaluation).value(); }));
+
+    const auto& set_counts = boost::copy_range<std::vector<int>>(
+      merged_result.program_evaluations |
+      boost::adaptors::transformed([](const auto& program_path_and_program_evaluation) { return std::get<1>(program_path_and_program_evaluation).set_count(); }));
+
+    liars_dice::show_scores(program_paths, scores, set_counts);
+  }();
+
+  [&]() {
+    auto ofstream = std::ofstream(argv[1]);
+    ofstream << liars_dice::write_json(merged_result, std::function(liars_dice::write_championship_result));
+    ofstream.close();
+  }();
+
+  liars_dice::write_past_games_file(argv[2], past_games);
+
+  return 0;
+}
@@ -0,0 +1,188 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/filesystem.hpp>
+#include <boost/range/adaptors.hpp>
+#include <boost/range/algorithm.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+namespace liars_dice {
+  // ディーラーのメモリ使用量（Resident Set Size）。Linux以外では0を返します。
+  inline auto resident_set_size() noexcept {
+    #ifdef _MSC_VER
+    return static_cast<std::int64_t>(0);
+    #else
+    auto ifstream = std::ifstream("/proc/self/statm");
+
+    auto size = static_cast<std::int64_t>(0);
+    auto resident = static_cast<std::int64_t>(0);
+
+    if (!(ifstream >> size >> resident)) {
+      return static_cast<std::int64_t>(0);
+    }
+
+    return resident * sysconf(_SC_PAGESIZE);
+    #endif
+  }
+
+  // Prometheusのラベルの値のエスケープ。Windowsのパスには\が含まれるので。
+  inline auto prometheus_label_value(const std::string& string) noexcept {
+    auto result = std::string();
+
+    for (const auto& c: string) {
+      if (c == '\\' || c == '"') {
+        result += '\\';
+      }
+
+      result += c;
+    }
+
+    return result;
+  }
+
+  // 長時間の選手権の進捗を監視するための、実行中の計測値。Prometheusのtext formatでファイルに出力します。パスが指定されていない場合は、計測だけして出力はしません。
+  class championship_metrics final {
+    std::optional<std::string> _path_string;
+    std::chrono::seconds _interval;
+    int _min_set_count;
+
+    std::chrono::steady_clock::time_point _starting_time;
+    std::chrono::steady_clock::time_point _written_time;
+
+    std::unordered_map<std::string, int> _program_set_counts;
+    std::int64_t _set_count;
+    std::int64_t _game_count;
+    std::int64_t _move_count;
+    int _live_child_process_count;
+
+  public:
+    championship_metrics(const std::optional<std::string>& path_string, const std::chrono::seconds& interval, int min_set_count, const std::vector<std::string>& program_paths) noexcept:
+      _path_string(path_string),
+      _interval(interval),
+      _min_set_count(min_set_count),
+      _starting_time(std::chrono::steady_clock::now()),
+      _written_time(_starting_time),
+      _program_set_counts(boost::copy_range<std::unordered_map<std::string, int>>(program_paths | boost::adaptors::transformed([](const auto& program_path) { return std::make_pair(program_path, 0); }))),
+      _set_count(0),
+      _game_count(0),
+      _move_count(0),
+      _live_child_process_count(0)
+    {
+      ;
+    }
+
+    auto add_set(const std::vector<std::string>& program_paths) noexcept {
+      for (const auto& program_path: program_paths) {
+        _program_set_counts[program_path]++;
+      }
+
+      _set_count++;
+    }
+
+    auto add_game(int move_count) noexcept {
+      _game_count++;
+      _move_count += move_count;
+    }
+
+    auto add_live_child_process_count(int delta) noexcept {
+      _live_child_process_count += delta;
+    }
+
+    // 一番セット数が少ないプログラムがmin_set_countに達するまでの、ざっくりとした予測時間。
+    auto estimated_remaining_seconds(double elapsed_seconds) const noexcept {
+      const auto& min_program_set_count = std::empty(_program_set_counts) ? 0 : boost::min_element(_program_set_counts, [](const auto& program_set_count_1, const auto& program_set_count_2) { return program_set_count_1.second < program_set_count_2.second; })->second;
+
+      if (min_program_set_count >= _min_set_count) {
+        return 0.0;
+      }
+
+      if (min_program_set_count == 0) {
+        return -1.0;  // まだ予測できません。
+      }
+
+      return elapsed_seconds / min_program_set_count * (_min_set_count - min_program_set_count);
+    }
+
+    auto write() {
+      if (!_path_string) {
+        return;
+      }
+
+      _written_time = std::chrono::steady_clock::now();
+
+      const auto& elapsed_seconds = std::chrono::duration<double>(_written_time - _starting_time).count();
+      const auto& cpu_seconds = static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+
+      // 書き込み途中のファイルを読まれないように、一時ファイルに書いてからリネームします。
+      const auto& temporary_path_string = _path_string.value() + ".tmp";
+
+      [&]() {
+        auto ofstream = std::ofstream(temporary_path_string);
+
+        const auto& write_metric = [&](const auto& name, const auto& type, const auto& help, const auto& value) {
+          ofstream << "# HELP liars_dice_" << name << " " << help << std::endl;
+          ofstream << "# TYPE liars_dice_" << name << " " << type << std::endl;
+          ofstream << "liars_dice_" << name << " " << value << std::endl;
+        };
+
+        write_metric("elapsed_seconds", "gauge", "Seconds since the championship started.", elapsed_seconds);
+        write_metric("sets_total", "counter", "Sets played.", _set_count);
+        write_metric("games_total", "counter", "Games played.", _game_count);
+        write_metric("moves_total", "counter", "Actions taken in all games.", _move_count);
+        write_metric("sets_per_second", "gauge", "Average sets per second.", elapsed_seconds > 0 ? _set_count / elapsed_seconds : 0.0);
+        write_metric("games_per_second", "gauge", "Average games per second.", elapsed_seconds > 0 ? _game_count / elapsed_seconds : 0.0);
+        write_metric("moves_per_game", "gauge", "Average actions per game.", _game_count > 0 ? static_cast<double>(_move_count) / _game_count : 0.0);
+        write_metric("resident_memory_bytes", "gauge", "Resident set size of the dealer.", resident_set_size());
+        write_metric("cpu_seconds_total", "counter", "CPU time used by the dealer.", cpu_seconds);
+        write_metric("live_child_processes", "gauge", "Program processes currently running.", _live_child_process_count);
+        write_metric("min_set_count", "gauge", "Target set count per program.", _min_set_count);
+        write_metric("estimated_remaining_seconds", "gauge", "Estimated seconds until every program reaches min_set_count (-1 if unknown).", estimated_remaining_seconds(elapsed_seconds));
+
+        ofstream << "# HELP liars_dice_program_sets_total Sets played by each program." << std::endl;
+        ofstream << "# TYPE liars_dice_program_sets_total counter" << std::endl;
+        for (const auto& [program_path, program_set_count]: _program_set_counts) {
+          ofstream << "liars_dice_program_sets_total{program=\"" << prometheus_label_value(program_path) << "\"} " << program_set_count << std::endl;
+        }
+
+        ofstream.close();
+      }();
+
+      // noexceptのplay_championshipから呼ばれるので、例外にはせずに報告だけして、次の出力で再挑戦します。
+      auto error_code = boost::system::error_code();
+
+      boost::filesystem::rename(temporary_path_string, _path_string.value(), error_code);
+
+      if (error_code) {
+        std::cerr << "*** CANNOT WRITE METRICS to " << _path_string.value() << ": " << error_code.message() << " ***" << std::endl;
+      }
+    }
+
+    // 前回の出力からintervalが過ぎていたら出力します。
+    auto write_if_needed() {
+      if (!_path_string || std::chrono::steady_clock::now() - _written_time < _interval) {
+        return;
+      }
+
+      write();
+    }
+  };
+}
@@ -0,0 +1,125 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/range/adaptors.hpp>
+#include <boost/range/numeric.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "game.hpp"
+
+namespace liars_dice {
+  // 最初の宣言の表。最初の宣言は、プレイヤーの数と、自分の手と、見えないダイスの数だけで決まるので、liars-dice-openingで全ての場合をシミュレーションして作成しておきます。
+  // プログラムは、ファイルをメモリにマップしておいて、最初の手番ではO(1)で表を引けます。
+  //
+  // ヘッダー（32バイト）: "LDOPENG"、バージョン（1バイト）、プレイヤーの最大数（4バイト）、1人あたりのダイスの最大数（4バイト）、予備（16バイト）
+  // 表:                  宣言の番号（bid_index()。1バイト。0は表にないことを表す）の、[プレイヤーの数 - 2][自分のダイスの数 - 1][見えないダイスの数][手の番号]の配列。
+  //                      手の番号の次元は、ダイスの最大数の手の数の大きさにしています。
+
+  constexpr auto opening_table_magic       = "LDOPENG";
+  constexpr auto opening_table_version     = 1;
+  constexpr auto opening_table_header_size = 32;
+
+  inline auto opening_table_index(int player_count, int dice_count, int secret_dice_count, int hand_index, int max_player_count, int max_dice_count) noexcept {
+    if (player_count < 2 || player_count > max_player_count || dice_count < 1 || dice_count > max_dice_count || secret_dice_count < 0 || secret_dice_count > (max_player_count - 1) * max_dice_count) {
+      return static_cast<std::int64_t>(-1);
+    }
+
+    return ((static_cast<std::int64_t>(player_count - 2) * max_dice_count + dice_count - 1) * ((max_player_count - 1) * max_dice_count + 1) + secret_dice_count) * hand_count(max_dice_count) + hand_index;
+  }
+
+  inline auto opening_table_size(int max_player_count, int max_dice_count) noexcept {
+    return static_cast<std::int64_t>(max_player_count - 1) * max_dice_count * ((max_player_count - 1) * max_dice_count + 1) * hand_count(max_dice_count);
+  }
+
+  // object -> binary
+
+  // bid_indicesは、opening_table_index()の順に並べた宣言の番号です。
+  inline auto write_opening_table(int max_player_count, int max_dice_count, const std::vector<std::uint8_t>& bid_indices) {
+    const auto& put_uint = [](std::string& buffer, std::uint64_t value, int byte_count) {
+      for (auto i = 0; i < byte_count; ++i) {
+        buffer.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+      }
+    };
+
+    auto result = std::string(opening_table_magic);
+
+    result.push_back(static_cast<char>(opening_table_version));
+    put_uint(result, max_player_count, 4);
+    put_uint(result, max_dice_count, 4);
+    put_uint(result, 0, 16);
+
+    result.append(std::begin(bid_indices), std::end(bid_indices));
+
+    return result;
+  }
+
+  // binary -> object
+
+  class opening_table final {
+    boost::interprocess::file_mapping _file_mapping;
+    boost::interprocess::mapped_region _mapped_region;
+    const unsigned char* _data;
+    int _max_player_count;
+    int _max_dice_count;
+
+  public:
+    opening_table(const std::string& path_string): _file_mapping(path_string.c_str(), boost::interprocess::read_only), _mapped_region(_file_mapping, boost::interprocess::read_only), _data(static_cast<const unsigned char*>(_mapped_region.get_address())) {
+      if (_mapped_region.get_size() < opening_table_header_size || std::string(reinterpret_cast<const char*>(_data), 7) != opening_table_magic || _data[7] != opening_table_version) {
+        throw std::runtime_error("not an opening table: " + path_string);
+      }
+
+      _max_player_count = static_cast<int>(_data[8] | _data[9] << 8 | _data[10] << 16 | _data[11] << 24);
+      _max_dice_count   = static_cast<int>(_data[12] | _data[13] << 8 | _data[14] << 16 | _data[15] << 24);
+
+      if (_mapped_region.get_size() < static_cast<std::size_t>(opening_table_header_size + opening_table_size(_max_player_count, _max_dice_count))) {
+        throw std::runtime_error("truncated opening table: " + path_string);
+      }
+    }
+
+    auto max_player_count() const noexcept {
+      return _max_player_count;
+    }
+
+    auto max_dice_count() const noexcept {
+      return _max_dice_count;
+    }
+
+    // gameが最初の手番で、表にある場合は、最初の宣言を返します。
+    auto opening(const game& game) const noexcept -> std::optional<bid> {
+      if (!std::empty(game.players()[game.previous_player_index()].actions())) {
+        return std::nullopt;
+      }
+
+      const auto& faces = game.players()[game.player_index()].faces();
+
+      const auto& dice_count        = static_cast<int>(std::size(faces));
+      const auto& secret_dice_count = boost::accumulate(game.players() | boost::adaptors::transformed([](const auto& player) { return static_cast<int>(std::size(player.faces())); }), 0) - dice_count;
+
+      const auto& index = opening_table_index(static_cast<int>(std::size(game.players())), dice_count, secret_dice_count, hand_index(faces), _max_player_count, _max_dice_count);
+
+      if (index < 0 || _data[opening_table_header_size + index] == 0) {
+        return std::nullopt;
+      }
+
+      const auto& result = index_bid(_data[opening_table_header_size + index]);
+
+      if (!game.is_legal_action(result)) {
+        return std::nullopt;
+      }
+
+      return result;
+    }
+  };
+}
@@ -0,0 +1,187 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../game.hpp"
+#include "../opening.hpp"
+#include "../util.hpp"
+#include "../../fool/fool.hpp"
+#include "../../hardhead/hardhead.hpp"
+#include "../../optimist/optimist.hpp"
+#include "../../pessimist/pessimist.hpp"
+#include "../../timid/timid.hpp"
+
+// 最初の宣言の表を作成します。プレイヤーの数、自分のダイスの数、見えないダイスの数、自分の手の全ての組み合わせについて、候補の宣言をシミュレーションで評価します。
+// 見えないダイスは、他のプレイヤーにできるだけ均等に配ります。相手はopponentsからランダムに選んだサンプル・プログラムで、自分は2手目以降をhardheadと同じ戦略で打ちます。
+// 候補の宣言は、目毎に、自分の手と見えないダイスの1/3から見込んだ個数の前後2個です。全ての候補を同じ相手の手で評価して（共通乱数法）、失うダイスが最も少ない宣言を選びます。
+
+inline auto create_program(const std::string& name) -> std::shared_ptr<liars_dice::program> {
+  if (name == "fool") {
+    return std::make_shared<fool>();
+  }
+
+  if (name == "hardhead") {
+    return std::make_shared<hardhead>();
+  }
+
+  if (name == "optimist") {
+    return std::make_shared<optimist>();
+  }
+
+  if (name == "pessimist") {
+    return std::make_shared<pessimist>();
+  }
+
+  if (name == "timid") {
+    return std::make_shared<timid>();
+  }
+
+  return nullptr;
+}
+
+inline auto split(const std::string& string, char delimiter) {
+  auto result = std::vector<std::string>();
+
+  auto stream = std::stringstream(string);
+
+  for (auto item = std::string(); std::getline(stream, item, delimiter); ) {
+    result.emplace_back(item);
+  }
+
+  return result;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2 || argc > 6) {
+    std::cerr << "usage: liars-dice-opening table-path [opponents [max-player-count [max-dice-count [game-count]]]]" << std::endl;
+    std::exit(1);
+  }
+
+  const auto& opponent_names   = split(argc > 2 ? argv[2] : "hardhead", ',');
+  const auto& max_player_count = argc > 3 ? std::stoi(argv[3]) : 6;
+  const auto& max_dice_count   = argc > 4 ? std::stoi(argv[4]) : 5;
+  const auto& game_count       = argc > 5 ? std::stoi(argv[5]) : 100;
+
+  for (const auto& opponent_name: opponent_names) {
+    if (!create_program(opponent_name)) {
+      std::cerr << "unknown opponent: " << opponent_name << std::endl;
+      std::exit(1);
+    }
+  }
+
+  const auto& starting_time = std::chrono::steady_clock::now();
+  const auto& seed          = std::random_device()() * static_cast<std::uint64_t>(0x100000000) + std::random_device()();
+
+  // 表の升目の、(プレイヤーの数, 自分のダイスの数, 見えないダイスの数, 手の番号)。
+  const auto& cells = [&]() {
+    auto result = std::vector<std::tuple<int, int, int, int>>();
+
+    for (auto player_count = 2; player_count <= max_player_count; ++player_count) {
+      for (auto dice_count = 1; dice_count <= max_dice_count; ++dice_count) {
+        for (auto secret_dice_count = player_count - 1; secret_dice_count <= (player_count - 1) * max_dice_count; ++secret_dice_count) {
+          for (auto hand_index = 0; hand_index < liars_dice::hand_count(dice_count); ++hand_index) {
+            result.emplace_back(player_count, dice_count, secret_dice_count, hand_index);
+          }
+        }
+      }
+    }
+
+    return result;
+  }();
+
+  auto bid_indices = std::vector<std::uint8_t>(liars_dice::opening_table_size(max_player_count, max_dice_count), 0);
+
+  util::parallel_for(
+    static_cast<int>(std::size(cells)),
+    [&](const auto& cell_index) {
+      const auto& [player_count, dice_count, secret_dice_count, hand_index] = cells[cell_index];
+
+      const auto& faces = liars_dice::index_hand(dice_count, hand_index);
+
+      const auto& candidate_bids = [&, dice_count = dice_count, secret_dice_count = secret_dice_count]() {  // P0588R1...
+        auto result = std::vector<liars_dice::bid>();
+
+        for (auto face = 2; face <= 6; ++face) {
+          const auto& estimated_count = static_cast<int>(std::round(std::count_if(std::begin(faces), std::end(faces), [&](const auto& face_) { return face_ == 1 || face_ == face; }) + secret_dice_count / 3.0f));
+
+          for (auto count = std::max(estimated_count - 2, 1); count <= std::min({estimated_count + 2, dice_count + secret_dice_count, liars_dice::game::default_max_bid_count}); ++count) {
+            result.emplace_back(face, count);
+          }
+        }
+
+        return result;
+      }();
+
+      auto opponents      = boost::copy_range<std::vector<std::shared_ptr<liars_dice::program>>>(opponent_names | boost::adaptors::transformed([](const auto& opponent_name) { return create_program(opponent_name); }));
+      auto opener         = create_program("hardhead");
+      auto random_engine  = std::mt19937_64(util::mix_seed(seed, cell_index));
+      auto total_rewards  = std::vector<double>(std::size(candidate_bids), 0.0);
+
+      for (auto i = 0; i < game_count; ++i) {
+        // 相手の手と、相手のプログラム。
+        auto players  = std::vector<liars_dice::player>{liars_dice::player("A", faces)};
+        auto programs = std::vector<liars_dice::program*>{opener.get()};
+
+        for (auto j = 1; j < player_count; ++j) {
+          const auto& opponent_dice_count = secret_dice_count / (player_count - 1) + (j - 1 < secret_dice_count % (player_count - 1) ? 1 : 0);
+
+          auto opponent_faces = std::vector<int>(opponent_dice_count);
+
+          for (auto& face: opponent_faces) {
+            face = std::uniform_int_distribution(1, 6)(random_engine);
+          }
+
+          std::sort(std::begin(opponent_faces), std::end(opponent_faces));
+
+          players.emplace_back(std::string(1, static_cast<char>('A' + j)), opponent_faces);
+          programs.emplace_back(opponents[std::uniform_int_distribution(0, static_cast<int>(std::size(opponents)) - 1)(random_engine)].get());
+        }
+
+        for (auto j = 0; j < static_cast<int>(std::size(candidate_bids)); ++j) {
+          auto game = liars_dice::game(players);
+
+          game.do_action(candidate_bids[j]);
+
+          const auto& reward = [&, dice_count = dice_count]() {  // P0588R1...
+            while (!game.is_end()) {
+              const auto& action = programs[game.player_index()]->action(game.masked_game());
+
+              if (!game.is_legal_action(action)) {
+                return game.player_index() == 0 ? -dice_count : 0;
+              }
+
+              game.do_action(action);
+            }
+
+            return std::max(game.dice_count_deltas()[0], -dice_count);
+          }();
+
+          total_rewards[j] += reward;
+        }
+      }
+
+      const auto& best_bid = candidate_bids[std::max_element(std::begin(total_rewards), std::end(total_rewards)) - std::begin(total_rewards)];
+
+      bid_indices[liars_dice::opening_table_index(player_count, dice_count, secret_dice_count, hand_index, max_player_count, max_dice_count)] = static_cast<std::uint8_t>(liars_dice::bid_index(best_bid));
+    });
+
+  auto ofstream = std::ofstream(argv[1], std::ios::out | std::ios::binary);
+  ofstream << liars_dice::write_opening_table(max_player_count, max_dice_count, bid_indices);
+  ofstream.close();
+
+  std::cout << "cells\t" << std::size(cells) << std::endl;
+  std::cout << "games\t" << static_cast<std::int64_t>(std::size(cells)) * game_count << " x candidates" << std::endl;
+  std::cout << "seconds\t" << std::fixed << std::setprecision(3) << std::chrono::duration<double>(std::chrono::steady_clock::now() - starting_time).count() << std::defaultfloat << std::endl;
+
+  return 0;
+}
@@ -3,6 +3,8 @@
 #include <string>
 #include <vector>
 
+#include "career_map.hpp"
+#include "career_summary.hpp"
 #include "game.hpp"
 #include "json.hpp"
 
@@ -10,15 +12,29 @@ namespace liars_dice {
   class program {
   public:
     virtual void check_other_programs(const std::vector<career>& careers) noexcept = 0;
+    // ディーラーを--career-mapで起動して、runと同じディレクトリのcapabilitiesファイルにcheck_other_program_mapと書いた場合は、check_other_programsの代わりに呼ばれます。
+    // コピーしたくない場合は、オーバーライドしてビューで読んでください。ただし、career_mapはこの呼び出しの間だけ有効な一時オブジェクトなので、ビューを呼び出しの後まで保持してはいけません。
+    virtual void check_other_program_map(const career_map& career_map) noexcept {
+      check_other_programs(career_map.careers());
+    }
+    // ディーラーを--career-summariesで起動して、runと同じディレクトリのcapabilitiesファイルにcheck_career_summariesと書いた場合だけ呼ばれます。
+    // dist/の実行ファイルはこのコマンドを知らない版のprogram.hppでビルドされているので、作り直してからcapabilitiesに書いてください。
+    virtual void check_career_summaries(const std::vector<career_summary>& career_summaries) noexcept {
+      ;
+    }
     virtual liars_dice::action action(const game& game) noexcept = 0;
     virtual void game_end(const game& game) noexcept = 0;
     virtual void terminate() noexcept {
       ;
     }
 
+    // 文字列とゲームは、手番毎にメモリを確保し直さないように使い回します。
     auto execute() {
+      auto parameter_string = std::string();
+      auto game_            = game(std::vector<player>());
+
       for (auto command_string = std::string(); std::getline(std::cin, command_string); ) {
-        auto parameter_string = std::string(); std::getline(std::cin, parameter_string);
+        std::getline(std::cin, parameter_string);
 
         if (command_string == "check_other_programs") {
           check_other_programs(read_json(parameter_string, std::function(read_careers))); std::cout << "OK" << std::endl;
@@ -26,14 +42,33 @@ namespace liars_dice {
           continue;
         }
 
+        if (command_string == "check_other_program_map") {
+          // ファイルが書き換えられていたり壊れていたりしてマップできない場合は、戦歴なしで続けます。
+          try {
+            check_other_program_map(career_map(read_json(parameter_string, std::function(read_career_map_location))));
+          } catch (const std::exception&) {
+            check_other_programs(std::vector<career>());
+          }
+
+          std::cout << "OK" << std::endl;
+
+          continue;
+        }
+
+        if (command_string == "check_career_summaries") {
+          check_career_summaries(read_json(parameter_string, std::function(read_career_summaries))); std::cout << "OK" << std::endl;
+
+          continue;
+        }
+
         if (command_string == "action") {
-          std::cout << write_json(action(read_json(parameter_string, std::function(read_game))), std::function(write_action)) << std::endl;
+          read_json(parameter_string, game_, std::function(read_game_in_place)); write_json(std::cout, action(game_), std::function(write_action)); std::cout << std::endl;
 
           continue;
         }
 
         if (command_string == "game_end") {
-          game_end(read_json(parameter_string, std::function(read_game))); std::cout << "OK" << std::endl;
+          read_json(parameter_string, game_, std::function(read_game_in_place)); game_end(game_); std::cout << "OK" << std::endl;
 
           continue;
         }
@@ -2,6 +2,7 @@
 
 #include <chrono>
 #include <future>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -14,8 +15,13 @@
 #pragma warning(pop)
 #endif
 
+#include "career_map.hpp"
+#include "career_summary.hpp"
 #include "game.hpp"
 #include "json.hpp"
+#include "resource_usage.hpp"
+#include "statistics.hpp"
+#include "trace.hpp"
 
 namespace liars_dice {
   class program_proxy final {
@@ -29,27 +35,60 @@ namespace liars_dice {
 
     boost::process::child _child;
 
+    std::future<std::string> _reply;  // 応答を待つスレッド。タイムアウトした場合は、応答が届くまで次のコマンドを送らないように、ここに残しておきます。
+
+    communication_statistics _statistics;
+
+    std::map<std::string, resource_usage> _command_resource_usages;  // コマンド毎の、プログラムが使用したリソース。
+    resource_usage _total_resource_usage;                            // 最後に計測した、プログラムが使用したリソースの合計。
+
   public:
     program_proxy(const std::string& program_path_string) noexcept:
       _program_path_string(program_path_string),
-      _child(_program_path_string, boost::process::std_in < _cin, boost::process::std_out > _cout, boost::process::std_err > _cerr, _io_service)
+      _child(_program_path_string, boost::process::std_in < _cin, boost::process::std_out > _cout, boost::process::std_err > _cerr, _io_service),
+      _total_resource_usage{0, 0, 0, 0, 0}
     {
       ;
     }
 
     auto call_program(const std::string& command, const std::string& parameter, int timeout_milliseconds) {
+      LIARS_DICE_TRACE_SCOPE(command, _program_path_string);
+
       if (!_child.running()) {
         std::cout << "*** COMMUNICATION ERROR on " << _program_path_string << " ***" << std::endl;
 
+        _statistics.add_communication_error();
+
         throw std::exception();  // TODO: 専用の例外クラスを作る！
       }
 
+      // 前回タイムアウトした応答がまだ届かない場合は、プログラムは前のコマンドを処理中なので、このコマンドもタイムアウトにします。届いていれば読み捨てます。
+      // 応答を待たずにfutureを破棄すると、デストラクタが応答が届くまで（応答しないプログラムなら永遠に）待ってしまいます。
+      if (_reply.valid()) {
+        if (_reply.wait_for(std::chrono::milliseconds(timeout_milliseconds)) == std::future_status::timeout) {
+          std::cout << "*** TIMEOUT on " << _program_path_string << " ***" << std::endl;
+
+          _statistics.add_timeout();
+
+          throw std::exception();  // TODO: 専用の例外クラスを作る！
+        }
+
+        _reply.get();
+      }
+
+      const auto& starting_resource_usage = process_tree_resource_usage(_child.id());
+      const auto& starting_time = std::chrono::steady_clock::now();
+
       _cin << command   << std::endl;
       _cin << parameter << std::endl;  // TODO: チューニング！　バッファーが溢れるみたいで、通信相手がJavaだとやたらと遅い……。
 
-      auto future = std::async(
+      _statistics.add_sent_byte_count(std::size(command) + 1 + std::size(parameter) + 1);
+
+      _reply = std::async(
         std::launch::async,
         [&]() {
+          LIARS_DICE_TRACE_SCOPE("getline");
+
           auto result = std::string();
 
           std::getline(_cout, result);
@@ -57,20 +96,33 @@ namespace liars_dice {
           return result;
         });
 
-      if (future.wait_for(std::chrono::milliseconds(timeout_milliseconds)) == std::future_status::timeout) {
+      if (_reply.wait_for(std::chrono::milliseconds(timeout_milliseconds)) == std::future_status::timeout) {
         std::cout << "*** TIMEOUT on " << _program_path_string << " ***" << std::endl;
 
+        _statistics.add_timeout();
+
         throw std::exception();  // TODO: 専用の例外クラスを作る！
       }
 
-      const auto& result = future.get();
+      const auto& result = _reply.get();
+      const auto& latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - starting_time);
+
+      // ホストが混んでいて遅いのか、プログラムがCPUを使い込んでいるのかを区別できるように、リソースの使用量も計測します。
+      _total_resource_usage = process_tree_resource_usage(_child.id());
+      _command_resource_usages[command] += _total_resource_usage - starting_resource_usage;
 
       if (result == "") {
         std::cout << "*** COMMUNICATION ERROR on " << _program_path_string << " ***" << std::endl;
 
+        _statistics.add_communication_error();
+
         throw std::exception();  // TODO: 専用の例外クラスを作る！
       }
 
+      // 通信エラーの応答時間が混ざらないように、応答を確認してから記録します。
+      _statistics.add_latency(command, latency);
+      _statistics.add_received_byte_count(std::size(result) + 1);
+
       return result;
     }
 
@@ -78,6 +130,14 @@ namespace liars_dice {
       call_program("check_other_programs", write_json(careers, std::function(write_careers)), 10000);
     }
 
+    auto check_other_program_map(const career_map_location& career_map_location) {
+      call_program("check_other_program_map", write_json(career_map_location, std::function(write_career_map_location)), 10000);
+    }
+
+    auto check_career_summaries(const std::vector<career_summary>& career_summaries) {
+      call_program("check_career_summaries", write_json(career_summaries, std::function(write_career_summaries)), 10000);
+    }
+
     auto action(const game& game) {
       return read_json(call_program("action", write_json(game, std::function(write_game)), 500), std::function(read_action));
     }
@@ -87,6 +147,13 @@ namespace liars_dice {
     }
 
     auto terminate() {
+      LIARS_DICE_TRACE_SCOPE("terminate", _program_path_string);
+
+      // 終了するとプロセスの情報が消えてしまうので、その前に計測しておきます。
+      if (_child.running()) {
+        _total_resource_usage = process_tree_resource_usage(_child.id());
+      }
+
       _cin.pipe().close();
 
       if (!_child.wait_for(std::chrono::milliseconds(500))) {  // Ubuntu19.04 + boost 1.67だと、必ず500msec待った挙げ句にfalseを返しやがる……。この3行をコメントアウトしてください。
@@ -94,6 +161,18 @@ namespace liars_dice {
       }
     }
 
+    const auto& statistics() const noexcept {
+      return _statistics;
+    }
+
+    const auto& command_resource_usages() const noexcept {
+      return _command_resource_usages;
+    }
+
+    const auto& total_resource_usage() const noexcept {
+      return _total_resource_usage;
+    }
+
     std::string cerr() noexcept {
       _io_service.run();
 
@@ -0,0 +1,180 @@
+﻿#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/range/adaptors.hpp>
+#include <boost/range/irange.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "game.hpp"
+#include "json.hpp"
+#include "program_proxy.hpp"
+#include "statistics.hpp"
+
+namespace liars_dice {
+  // プロセス境界を越える通信の計測に使用する、ペイロードのサイズ違いのゲーム。
+  struct proxy_benchmark_payload final {
+    std::string name;
+    liars_dice::game game;
+  };
+
+  // player_count人で、dice_count個ずつのダイスで、bid_count回宣言した後のゲームを作成します。
+  inline auto proxy_benchmark_game(int player_count, int dice_count, int bid_count) noexcept {
+    auto result = game(boost::copy_range<std::vector<player>>(
+      boost::irange(0, player_count) |
+      boost::adaptors::transformed([&](const auto& i) { return player(std::string(1, 'A' + i), std::vector<int>(dice_count, i % 6 + 1)); })));
+
+    for (auto i = 0; i < bid_count; ++i) {
+      result.do_action(bid(i % 5 + 2, i / 5 + 1));
+    }
+
+    return result;
+  }
+
+  inline auto proxy_benchmark_payloads() noexcept {
+    return std::vector<proxy_benchmark_payload>{
+      proxy_benchmark_payload{"small (2 players, 1 dice, 1 bid)",    proxy_benchmark_game(2, 1,  1)},
+      proxy_benchmark_payload{"medium (6 players, 5 dice, 10 bids)", proxy_benchmark_game(6, 5, 10)},
+      proxy_benchmark_payload{"large (6 players, 5 dice, 95 bids)",  proxy_benchmark_game(6, 5, 95)}};
+  }
+
+  struct proxy_benchmark_result final {
+    std::string payload_name;
+    int byte_count;
+    latency_histogram action_latency_histogram;
+    latency_histogram game_end_latency_histogram;
+    double messages_per_second;
+  };
+
+  // ひとつのプログラムに、actionとgame_endを交互にmessage_count回ずつ送信して、往復の時間を計測します。
+  inline auto run_proxy_benchmark(const std::string& program_path_string, int message_count) {
+    auto result = std::vector<proxy_benchmark_result>();
+
+    auto program_proxy_ = program_proxy(program_path_string);
+
+    for (const auto& payload: proxy_benchmark_payloads()) {
+      const auto& masked_game = payload.game.masked_game();
+
+      // JavaやC#のJITが落ち着くまで、最初の1割は計測しません。
+      for (auto i = 0; i < message_count / 10; ++i) {
+        program_proxy_.action(masked_game);
+        program_proxy_.game_end(payload.game);
+      }
+
+      auto action_latency_histogram   = latency_histogram();
+      auto game_end_latency_histogram = latency_histogram();
+
+      const auto& starting_time = std::chrono::steady_clock::now();
+
+      for (auto i = 0; i < message_count; ++i) {
+        [&]() {
+          const auto& starting_time = std::chrono::steady_clock::now();
+
+          program_proxy_.action(masked_game);
+
+          action_latency_histogram.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - starting_time));
+        }();
+
+        [&]() {
+          const auto& starting_time = std::chrono::steady_clock::now();
+
+          program_proxy_.game_end(payload.game);
+
+          game_end_latency_histogram.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - starting_time));
+        }();
+      }
+
+      const auto& elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - starting_time).count();
+
+      result.emplace_back(proxy_benchmark_result{payload.name, static_cast<int>(std::size(write_json(payload.game, std::function(write_game)))), action_latency_histogram, game_end_latency_histogram, message_count * 2 / elapsed_seconds});
+    }
+
+    program_proxy_.terminate();
+
+    return result;
+  }
+
+  inline auto show_proxy_benchmark_results(const std::string& program_path_string, const std::vector<proxy_benchmark_result>& proxy_benchmark_results) noexcept {
+    std::cout << "# Proxy Benchmark " << program_path_string << std::endl;
+    std::cout << std::endl;
+
+    for (const auto& proxy_benchmark_result: proxy_benchmark_results) {
+      for (const auto& [command, latency_histogram]: {std::make_tuple("action", proxy_benchmark_result.action_latency_histogram), std::make_tuple("game_end", proxy_benchmark_result.game_end_latency_histogram)}) {
+        std::cout << proxy_benchmark_result.payload_name << "\t" << proxy_benchmark_result.byte_count << " bytes\t" << command << "\t" << std::fixed << std::setprecision(3) << latency_histogram.percentile(50) / 1000.0 << "\t" << latency_histogram.percentile(99) / 1000.0 << "\t" << latency_histogram.max() / 1000.0 << std::defaultfloat << std::endl;
+      }
+
+      std::cout << proxy_benchmark_result.payload_name << "\t" << std::fixed << std::setprecision(1) << proxy_benchmark_result.messages_per_second << std::defaultfloat << " messages/sec" << std::endl;
+    }
+
+    std::cout << std::endl;
+  }
+
+  // object -> json
+
+  inline auto write_proxy_benchmark_results(const std::vector<std::tuple<std::string, std::vector<proxy_benchmark_result>>>& program_proxy_benchmark_results, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartArray();
+    for (const auto& [program_path, proxy_benchmark_results]: program_proxy_benchmark_results) {
+      writer.StartObject();
+      writer.Key("path");
+      writer.String(program_path.c_str());
+      writer.Key("payloads");
+      writer.StartArray();
+      for (const auto& proxy_benchmark_result: proxy_benchmark_results) {
+        writer.StartObject();
+        writer.Key("name");
+        writer.String(proxy_benchmark_result.payload_name.c_str());
+        writer.Key("byte_count");
+        writer.Int(proxy_benchmark_result.byte_count);
+        writer.Key("commands");
+        writer.StartObject();
+        writer.Key("action");
+        write_latency_histogram(proxy_benchmark_result.action_latency_histogram, writer);
+        writer.Key("game_end");
+        write_latency_histogram(proxy_benchmark_result.game_end_latency_histogram, writer);
+        writer.EndObject();
+        writer.Key("messages_per_second");
+        writer.Double(proxy_benchmark_result.messages_per_second);
+        writer.EndObject();
+      }
+      writer.EndArray();
+      writer.EndObject();
+    }
+    writer.EndArray();
+  }
+
+  // 全てのプログラムの通信を計測します。プロトコルや通信の実装を変更した際の比較に使用してください。
+  inline auto run_proxy_benchmarks(const std::vector<std::string>& program_path_strings, int message_count, const std::optional<std::string>& result_path_string) {
+    auto program_proxy_benchmark_results = std::vector<std::tuple<std::string, std::vector<proxy_benchmark_result>>>();
+
+    for (const auto& program_path_string: program_path_strings) {
+      try {
+        const auto& proxy_benchmark_results = run_proxy_benchmark(program_path_string, message_count);
+
+        show_proxy_benchmark_results(program_path_string, proxy_benchmark_results);
+
+        program_proxy_benchmark_results.emplace_back(program_path_string, proxy_benchmark_results);
+
+      } catch (...) {
+        std::cout << "*** BENCHMARK FAILED on " << program_path_string << " ***" << std::endl;
+      }
+    }
+
+    if (result_path_string) {
+      auto ofstream = std::ofstream(result_path_string.value());
+      ofstream << write_json(program_proxy_benchmark_results, std::function(write_proxy_benchmark_results));
+      ofstream.close();
+    }
+  }
+}
@@ -0,0 +1,125 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/range/adaptors.hpp>
+#include <boost/range/algorithm.hpp>
+#include <boost/range/irange.hpp>
+#include <rapidjson/document.h>
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+namespace liars_dice {
+  // プログラムの強さの推定値。平均がmu、標準偏差がsigmaの正規分布で表現します（TrueSkillと同じ初期値）。
+  class rating final {
+    double _mu;
+    double _sigma;
+
+  public:
+    rating(double mu, double sigma) noexcept: _mu(mu), _sigma(sigma) {
+      ;
+    }
+
+    rating() noexcept: rating(25.0, 25.0 / 3) {
+      ;
+    }
+
+    const auto& mu() const noexcept {
+      return _mu;
+    }
+
+    const auto& sigma() const noexcept {
+      return _sigma;
+    }
+  };
+
+  // 1セット分のスコアで、参加したプログラムのレーティングを更新します。
+  // Weng and Lin (2011)のBradley-Terryモデル（全ペア版）です。スコアが高い方を勝ち、同じなら引き分けとして、全てのペアで比較します。
+  inline auto update_ratings(const std::vector<rating>& ratings, const std::vector<float>& scores) noexcept {
+    constexpr auto beta  = 25.0 / 6;
+    constexpr auto kappa = 0.0001;
+
+    return boost::copy_range<std::vector<rating>>(
+      boost::irange(0, static_cast<int>(std::size(ratings))) |
+      boost::adaptors::transformed(
+        [&](const auto& i) {
+          auto omega = 0.0;
+          auto delta = 0.0;
+
+          for (auto q = 0; q < static_cast<int>(std::size(ratings)); ++q) {
+            if (q == i) {
+              continue;
+            }
+
+            const auto& c = std::sqrt(ratings[i].sigma() * ratings[i].sigma() + ratings[q].sigma() * ratings[q].sigma() + 2 * beta * beta);
+            const auto& p = 1 / (1 + std::exp((ratings[q].mu() - ratings[i].mu()) / c));
+            const auto& s = scores[i] > scores[q] ? 1.0 : scores[i] < scores[q] ? 0.0 : 0.5;
+
+            const auto& variance_ratio = ratings[i].sigma() * ratings[i].sigma() / c;
+
+            omega += variance_ratio * (s - p);
+            delta += ratings[i].sigma() / c * variance_ratio / c * p * (1 - p);
+          }
+
+          return rating(ratings[i].mu() + omega, ratings[i].sigma() * std::sqrt(std::max(1 - delta, kappa)));
+        }));
+  }
+
+  // rating_1のプログラムが、rating_2のプログラムより強い確率。
+  inline auto probability_of_superiority(const rating& rating_1, const rating& rating_2) noexcept {
+    return 0.5 * std::erfc(-(rating_1.mu() - rating_2.mu()) / std::sqrt(2 * (rating_1.sigma() * rating_1.sigma() + rating_2.sigma() * rating_2.sigma())));
+  }
+
+  // muで並べた順位の、隣り合う全てのペアの上下がconfidence以上の確率で確かなら、順位が確定したとみなします。
+  inline auto is_ranking_settled(const std::vector<rating>& ratings, double confidence) noexcept {
+    auto sorted_ratings = ratings;
+
+    boost::sort(sorted_ratings, [](const auto& rating_1, const auto& rating_2) { return rating_1.mu() > rating_2.mu(); });
+
+    for (auto i = 0; i < static_cast<int>(std::size(sorted_ratings)) - 1; ++i) {
+      if (probability_of_superiority(sorted_ratings[i], sorted_ratings[i + 1]) < confidence) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // object -> json
+
+  inline auto write_program_ratings(const std::vector<std::tuple<std::string, rating>>& program_ratings, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartArray();
+    for (const auto& [program_path, rating]: program_ratings) {
+      writer.StartObject();
+      writer.Key("path");
+      writer.String(program_path.c_str());
+      writer.Key("mu");
+      writer.Double(rating.mu());
+      writer.Key("sigma");
+      writer.Double(rating.sigma());
+      writer.EndObject();
+    }
+    writer.EndArray();
+  }
+
+  // json -> object
+
+  inline auto read_program_ratings(const rapidjson::Value& value) noexcept {
+    auto result = std::vector<std::tuple<std::string, rating>>();
+
+    for (auto it = value.Begin(); it != value.End(); ++it) {
+      result.emplace_back((*it)["path"].GetString(), rating((*it)["mu"].GetDouble(), (*it)["sigma"].GetDouble()));
+    }
+
+    return result;
+  }
+}
@@ -0,0 +1,41 @@
+﻿#pragma once
+
+#include <vector>
+
+#include "game.hpp"
+
+namespace liars_dice {
+  // 記録されたゲームを最初から再生して、それぞれの手を打つ直前の状態と、実際に打たれた手をfunctionに渡します。
+  // play_gameは0番目のプレイヤーから開始して、宣言の度に次のプレイヤーに手番が移るので、i巡目のj番目のプレイヤーの手の順になります。
+  template <typename Function>
+  inline auto for_each_recorded_action(const game& recorded_game, Function&& function) {
+    auto game = liars_dice::game(boost::copy_range<std::vector<player>>(
+      recorded_game.players() |
+      boost::adaptors::transformed([](const auto& player) { return liars_dice::player(player.id(), player.faces()); })),
+      0,
+      recorded_game.max_bid_count());
+
+    for (auto i = 0; ; ++i) {
+      for (auto j = 0; j < static_cast<int>(std::size(recorded_game.players())); ++j) {
+        if (i >= static_cast<int>(std::size(recorded_game.players()[j].actions()))) {
+          return;
+        }
+
+        const auto& action = recorded_game.players()[j].actions()[i];
+
+        function(static_cast<const liars_dice::game&>(game), action);
+
+        game.do_action(action);
+      }
+    }
+  }
+
+  // 2つの手が同じかどうか。
+  inline auto is_same_action(const action& action_1, const action& action_2) noexcept {
+    if (action_1.bid() && action_2.bid()) {
+      return action_1.bid()->face() == action_2.bid()->face() && action_1.bid()->min_count() == action_2.bid()->min_count();
+    }
+
+    return action_1.challenge().has_value() && action_2.challenge().has_value();
+  }
+}
@@ -0,0 +1,155 @@
+﻿#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/filesystem.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "../game.hpp"
+#include "../game_log.hpp"
+#include "../json.hpp"
+#include "../program_proxy.hpp"
+#include "../replay.hpp"
+#include "../statistics.hpp"
+#include "../../fool/fool.hpp"
+#include "../../hardhead/hardhead.hpp"
+#include "../../optimist/optimist.hpp"
+#include "../../pessimist/pessimist.hpp"
+#include "../../timid/timid.hpp"
+
+// all-games.jsonに記録されたゲームの、全ての手の直前の状態をプログラムに送って、プログラムが返す手と記録された手を比較します。
+// プログラムには、runのパス（program_proxy経由）か、サンプル・プログラムの名前（プロセス内で実行）を指定できます。
+
+int main(int argc, char** argv) {
+  if (argc != 3 && argc != 4) {
+    std::cerr << "usage: liars-dice-replay games-path (program-path | fool | hardhead | optimist | pessimist | timid) [result-path]" << std::endl;
+    std::exit(1);
+  }
+
+  const auto& games_path_string   = std::string(argv[1]);
+  const auto& program_path_string = std::string(argv[2]);
+
+  const auto& past_games = liars_dice::read_past_games_file(games_path_string);
+
+  // プログラムの手を取得する関数と、ゲームの終了を通知する関数を作成します。
+  auto in_process_programs = std::unordered_map<std::string, std::function<std::unique_ptr<liars_dice::program>()>>{
+    {"fool",      []() { return std::make_unique<fool>(); }},
+    {"hardhead",  []() { return std::make_unique<hardhead>(); }},
+    {"optimist",  []() { return std::make_unique<optimist>(); }},
+    {"pessimist", []() { return std::make_unique<pessimist>(); }},
+    {"timid",     []() { return std::make_unique<timid>(); }}};
+
+  auto in_process_program = std::unique_ptr<liars_dice::program>();
+  auto program_proxy      = std::unique_ptr<liars_dice::program_proxy>();
+
+  auto action_function   = std::function<liars_dice::action(const liars_dice::game&)>();
+  auto game_end_function = std::function<void(const liars_dice::game&)>();
+
+  if (in_process_programs.count(program_path_string) && !boost::filesystem::is_regular_file(program_path_string)) {
+    in_process_program = in_process_programs.at(program_path_string)();
+
+    in_process_program->check_other_programs({});
+
+    action_function   = [&](const auto& game) { return in_process_program->action(game); };
+    game_end_function = [&](const auto& game) { in_process_program->game_end(game); };
+
+  } else {
+    program_proxy = std::make_unique<liars_dice::program_proxy>(program_path_string);
+
+    program_proxy->check_other_programs({});
+
+    action_function   = [&](const auto& game) { return program_proxy->action(game); };
+    game_end_function = [&](const auto& game) { program_proxy->game_end(game); };
+  }
+
+  // 再生します。
+  auto latency_histogram = liars_dice::latency_histogram();
+  auto different_action_count = 0;
+
+  const auto& starting_time = std::chrono::steady_clock::now();
+
+  try {
+    for (const auto& [_, game]: past_games) {
+      liars_dice::for_each_recorded_action(
+        game,
+        [&](const auto& game, const auto& recorded_action) {
+          const auto& masked_game = game.masked_game();
+
+          const auto& starting_time = std::chrono::steady_clock::now();
+          const auto& action = action_function(masked_game);
+
+          latency_histogram.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - starting_time));
+
+          if (!liars_dice::is_same_action(action, recorded_action)) {
+            different_action_count++;
+          }
+        });
+
+      game_end_function(game);
+    }
+
+  } catch (...) {
+    std::cerr << "*** REPLAY ABORTED after " << latency_histogram.count() << " actions ***" << std::endl;
+  }
+
+  const auto& elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - starting_time).count();
+
+  if (program_proxy) {
+    program_proxy->terminate();
+  }
+
+  // 結果を出力します。
+  const auto& decisions_per_second = latency_histogram.count() / elapsed_seconds;
+  const auto& different_action_rate = latency_histogram.count() > 0 ? static_cast<double>(different_action_count) / latency_histogram.count() : 0.0;
+
+  std::cout << "# Replay" << std::endl;
+  std::cout << std::endl;
+  std::cout << "games\t" << std::size(past_games) << std::endl;
+  std::cout << "actions\t" << latency_histogram.count() << std::endl;
+  std::cout << "actions/sec\t" << std::fixed << std::setprecision(1) << decisions_per_second << std::endl;
+  std::cout << "p50 msec\t" << std::setprecision(3) << latency_histogram.percentile(50) / 1000.0 << std::endl;
+  std::cout << "p99 msec\t" << latency_histogram.percentile(99) / 1000.0 << std::endl;
+  std::cout << "max msec\t" << latency_histogram.max() / 1000.0 << std::endl;
+  std::cout << "different actions\t" << different_action_count << " (" << different_action_rate * 100 << "%)" << std::defaultfloat << std::endl;
+  std::cout << std::endl;
+
+  if (argc == 4) {
+    auto string_buffer = rapidjson::StringBuffer();
+    auto writer = rapidjson::Writer<rapidjson::StringBuffer>(string_buffer);
+
+    writer.StartObject();
+    writer.Key("games_path");
+    writer.String(games_path_string.c_str());
+    writer.Key("program");
+    writer.String(program_path_string.c_str());
+    writer.Key("game_count");
+    writer.Int(static_cast<int>(std::size(past_games)));
+    writer.Key("action_latency");
+    liars_dice::write_latency_histogram(latency_histogram, writer);
+    writer.Key("actions_per_second");
+    writer.Double(decisions_per_second);
+    writer.Key("different_action_count");
+    writer.Int(different_action_count);
+    writer.Key("different_action_rate");
+    writer.Double(different_action_rate);
+    writer.EndObject();
+
+    auto ofstream = std::ofstream(argv[3]);
+    ofstream << string_buffer.GetString() << std::endl;
+    ofstream.close();
+  }
+
+  return 0;
+}
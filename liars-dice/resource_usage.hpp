@@ -0,0 +1,149 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/filesystem.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+namespace liars_dice {
+  // プロセスが使用したリソース。
+  struct resource_usage final {
+    double user_seconds;
+    double system_seconds;
+    std::int64_t peak_resident_set_size;  // バイト。
+    std::int64_t voluntary_context_switch_count;
+    std::int64_t involuntary_context_switch_count;
+
+    auto& operator+=(const resource_usage& other) noexcept {
+      user_seconds                     += other.user_seconds;
+      system_seconds                   += other.system_seconds;
+      peak_resident_set_size            = std::max(peak_resident_set_size, other.peak_resident_set_size);
+      voluntary_context_switch_count   += other.voluntary_context_switch_count;
+      involuntary_context_switch_count += other.involuntary_context_switch_count;
+
+      return *this;
+    }
+  };
+
+  // 2つの時点の差分。ピークのメモリ使用量は差分にならないので、後の時点の値を使用します。
+  inline auto operator-(const resource_usage& resource_usage_1, const resource_usage& resource_usage_2) noexcept {
+    return resource_usage{
+      resource_usage_1.user_seconds                     - resource_usage_2.user_seconds,
+      resource_usage_1.system_seconds                   - resource_usage_2.system_seconds,
+      resource_usage_1.peak_resident_set_size,
+      resource_usage_1.voluntary_context_switch_count   - resource_usage_2.voluntary_context_switch_count,
+      resource_usage_1.involuntary_context_switch_count - resource_usage_2.involuntary_context_switch_count};
+  }
+
+  #ifndef _MSC_VER
+  inline auto child_pids(int pid) noexcept {
+    auto result = std::vector<int>();
+
+    try {
+      for (const auto& directory_entry: boost::filesystem::directory_iterator("/proc/" + std::to_string(pid) + "/task")) {
+        auto ifstream = std::ifstream((directory_entry.path() / "children").string());
+
+        for (auto child_pid = 0; ifstream >> child_pid; ) {
+          result.emplace_back(child_pid);
+        }
+      }
+
+    } catch (...) {
+      ;  // プロセスが終了した場合は、/procから消えてしまうので。
+    }
+
+    return result;
+  }
+
+  inline auto process_resource_usage(int pid) noexcept {
+    auto result = resource_usage{0, 0, 0, 0, 0};
+
+    // /proc/<pid>/statのutime、stime、cutime、cstime。waitされた子プロセス（run中のdirnameとか）の分も含めます。
+    [&]() {
+      auto ifstream = std::ifstream("/proc/" + std::to_string(pid) + "/stat");
+      auto line = std::string(); std::getline(ifstream, line);
+
+      const auto& position = line.rfind(')');
+      if (position == std::string::npos) {
+        return;
+      }
+
+      auto stream = std::stringstream(line.substr(position + 2));
+      auto fields = std::vector<std::string>();
+
+      for (auto field = std::string(); stream >> field && std::size(fields) < 15; ) {
+        fields.emplace_back(field);
+      }
+
+      if (std::size(fields) < 15) {
+        return;
+      }
+
+      const auto& clock_ticks = static_cast<double>(sysconf(_SC_CLK_TCK));
+
+      result.user_seconds   = (std::stoll(fields[11]) + std::stoll(fields[13])) / clock_ticks;
+      result.system_seconds = (std::stoll(fields[12]) + std::stoll(fields[14])) / clock_ticks;
+    }();
+
+    // /proc/<pid>/statusのVmHWMとコンテキスト・スイッチの回数。
+    [&]() {
+      auto ifstream = std::ifstream("/proc/" + std::to_string(pid) + "/status");
+
+      for (auto line = std::string(); std::getline(ifstream, line); ) {
+        auto stream = std::stringstream(line);
+        auto key = std::string(); stream >> key;
+        auto value = static_cast<std::int64_t>(0); stream >> value;
+
+        if (key == "VmHWM:") {
+          result.peak_resident_set_size = value * 1024;
+        }
+
+        if (key == "voluntary_ctxt_switches:") {
+          result.voluntary_context_switch_count = value;
+        }
+
+        if (key == "nonvoluntary_ctxt_switches:") {
+          result.involuntary_context_switch_count = value;
+        }
+      }
+    }();
+
+    return result;
+  }
+  #endif
+
+  // プロセスとその子孫プロセスのリソース使用量。runはシェル・スクリプトで、実際のプログラムは子プロセスになるので。Linux以外では0を返します。
+  inline resource_usage process_tree_resource_usage(int pid) noexcept {
+    #ifdef _MSC_VER
+    return resource_usage{0, 0, 0, 0, 0};
+    #else
+    auto result = process_resource_usage(pid);
+
+    for (const auto& child_pid: child_pids(pid)) {
+      const auto& child_resource_usage = process_tree_resource_usage(child_pid);
+
+      // 親子のプロセスは同時に動いているので、ピークのメモリ使用量は合計します。
+      const auto& peak_resident_set_size = result.peak_resident_set_size + child_resource_usage.peak_resident_set_size;
+
+      result += child_resource_usage;
+      result.peak_resident_set_size = peak_resident_set_size;
+    }
+
+    return result;
+    #endif
+  }
+}
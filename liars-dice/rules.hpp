@@ -0,0 +1,77 @@
+﻿#pragma once
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <rapidjson/document.h>
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "game.hpp"
+#include "json.hpp"
+
+namespace liars_dice {
+  // 選手権のルール。大きなテーブルでプログラムを試したい場合は、コマンドラインか設定ファイルで変更してください。
+  struct rules final {
+    int table_size    = 6;                             // 1セットに参加するプログラムの数。
+    int dice_count    = 5;                             // セットの開始時のダイスの数。
+    int max_bid_count = game::default_max_bid_count;   // 宣言できる個数の上限。
+  };
+
+  inline auto operator==(const rules& rules_1, const rules& rules_2) noexcept {
+    return rules_1.table_size == rules_2.table_size && rules_1.dice_count == rules_2.dice_count && rules_1.max_bid_count == rules_2.max_bid_count;
+  }
+
+  inline auto operator!=(const rules& rules_1, const rules& rules_2) noexcept {
+    return !(rules_1 == rules_2);
+  }
+
+  // object -> json
+
+  inline auto write_rules(const rules& rules, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartObject();
+    writer.Key("table_size");
+    writer.Int(rules.table_size);
+    writer.Key("dice_count");
+    writer.Int(rules.dice_count);
+    writer.Key("max_bid_count");
+    writer.Int(rules.max_bid_count);
+    writer.EndObject();
+  }
+
+  // json -> object
+
+  // 省略した項目は、標準のルールになります。
+  inline auto read_rules(const rapidjson::Value& value) noexcept {
+    auto result = rules();
+
+    if (value.HasMember("table_size")) {
+      result.table_size = value["table_size"].GetInt();
+    }
+
+    if (value.HasMember("dice_count")) {
+      result.dice_count = value["dice_count"].GetInt();
+    }
+
+    if (value.HasMember("max_bid_count")) {
+      result.max_bid_count = value["max_bid_count"].GetInt();
+    }
+
+    return result;
+  }
+
+  // file
+
+  inline auto read_rules_file(const std::string& path_string) {
+    auto ifstream = std::ifstream(path_string);
+    auto stream = std::stringstream(); stream << ifstream.rdbuf();
+
+    return read_json(stream.str(), std::function(read_rules));
+  }
+}
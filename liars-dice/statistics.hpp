@@ -0,0 +1,228 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+namespace liars_dice {
+  // HDRヒストグラム風の、応答時間（マイクロ秒）のヒストグラム。2のべき乗の区間毎に32個のバケットに分けるので、誤差は3%程度です。
+  class latency_histogram final {
+    static constexpr auto sub_bucket_bits  = 5;
+    static constexpr auto sub_bucket_count = 1 << sub_bucket_bits;
+    static constexpr auto bucket_count     = sub_bucket_count * 2 + sub_bucket_count * 40;  // 2^46マイクロ秒（約2年）まで。
+
+    std::vector<std::uint64_t> _counts;
+    std::uint64_t _count;
+    std::uint64_t _total;
+    std::uint64_t _max;
+
+    static auto bucket_index(std::uint64_t value) noexcept {
+      if (value < sub_bucket_count * 2) {
+        return static_cast<int>(value);
+      }
+
+      auto shift = 0;
+      while ((value >> shift) >= sub_bucket_count * 2) {
+        shift++;
+      }
+
+      return std::min(sub_bucket_count * 2 + (shift - 1) * sub_bucket_count + static_cast<int>((value >> shift) - sub_bucket_count), bucket_count - 1);
+    }
+
+    static auto bucket_highest_value(int index) noexcept {
+      if (index < sub_bucket_count * 2) {
+        return static_cast<std::uint64_t>(index);
+      }
+
+      const auto& shift = (index - sub_bucket_count * 2) / sub_bucket_count + 1;
+      const auto& sub_bucket_index = (index - sub_bucket_count * 2) % sub_bucket_count + sub_bucket_count;
+
+      return (static_cast<std::uint64_t>(sub_bucket_index + 1) << shift) - 1;
+    }
+
+  public:
+    latency_histogram() noexcept: _counts(bucket_count, 0), _count(0), _total(0), _max(0) {
+      ;
+    }
+
+    const auto& count() const noexcept {
+      return _count;
+    }
+
+    const auto& total() const noexcept {
+      return _total;
+    }
+
+    const auto& max() const noexcept {
+      return _max;
+    }
+
+    auto record(const std::chrono::microseconds& latency) noexcept {
+      const auto& value = static_cast<std::uint64_t>(std::max(latency.count(), static_cast<std::chrono::microseconds::rep>(0)));
+
+      _counts[bucket_index(value)]++;
+
+      _count++;
+      _total += value;
+      _max = std::max(_max, value);
+    }
+
+    auto merge(const latency_histogram& other) noexcept {
+      for (auto i = 0; i < bucket_count; ++i) {
+        _counts[i] += other._counts[i];
+      }
+
+      _count += other._count;
+      _total += other._total;
+      _max = std::max(_max, other._max);
+    }
+
+    // percentileは0〜100で指定します。バケットの上端の値を返すので、実際の値よりも少しだけ大きくなります。
+    auto percentile(double percentile) const noexcept {
+      if (_count == 0) {
+        return static_cast<std::uint64_t>(0);
+      }
+
+      const auto target_count = std::max(static_cast<std::uint64_t>(percentile / 100 * _count + 0.5), static_cast<std::uint64_t>(1));  // std::maxは参照を返すので、const auto&で受けてはダメ。
+
+      auto count = static_cast<std::uint64_t>(0);
+
+      for (auto i = 0; i < bucket_count; ++i) {
+        count += _counts[i];
+
+        if (count >= target_count) {
+          return std::min(bucket_highest_value(i), _max);
+        }
+      }
+
+      return _max;
+    }
+  };
+
+  // プログラムとの通信の統計情報。
+  class communication_statistics final {
+    std::map<std::string, latency_histogram> _latency_histograms;  // コマンド毎。
+    std::uint64_t _sent_byte_count;
+    std::uint64_t _received_byte_count;
+    int _timeout_count;
+    int _communication_error_count;
+
+  public:
+    communication_statistics() noexcept: _sent_byte_count(0), _received_byte_count(0), _timeout_count(0), _communication_error_count(0) {
+      ;
+    }
+
+    const auto& latency_histograms() const noexcept {
+      return _latency_histograms;
+    }
+
+    const auto& sent_byte_count() const noexcept {
+      return _sent_byte_count;
+    }
+
+    const auto& received_byte_count() const noexcept {
+      return _received_byte_count;
+    }
+
+    const auto& timeout_count() const noexcept {
+      return _timeout_count;
+    }
+
+    const auto& communication_error_count() const noexcept {
+      return _communication_error_count;
+    }
+
+    auto add_latency(const std::string& command, const std::chrono::microseconds& latency) noexcept {
+      _latency_histograms[command].record(latency);
+    }
+
+    auto add_sent_byte_count(std::uint64_t byte_count) noexcept {
+      _sent_byte_count += byte_count;
+    }
+
+    auto add_received_byte_count(std::uint64_t byte_count) noexcept {
+      _received_byte_count += byte_count;
+    }
+
+    auto add_timeout() noexcept {
+      _timeout_count++;
+    }
+
+    auto add_communication_error() noexcept {
+      _communication_error_count++;
+    }
+
+    auto merge(const communication_statistics& other) noexcept {
+      for (const auto& [command, latency_histogram]: other._latency_histograms) {
+        _latency_histograms[command].merge(latency_histogram);
+      }
+
+      _sent_byte_count           += other._sent_byte_count;
+      _received_byte_count       += other._received_byte_count;
+      _timeout_count             += other._timeout_count;
+      _communication_error_count += other._communication_error_count;
+    }
+  };
+
+  // object -> json
+
+  inline auto write_latency_histogram(const latency_histogram& latency_histogram, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartObject();
+    writer.Key("count");
+    writer.Uint64(latency_histogram.count());
+    writer.Key("total_microseconds");
+    writer.Uint64(latency_histogram.total());
+    writer.Key("p50_microseconds");
+    writer.Uint64(latency_histogram.percentile(50));
+    writer.Key("p99_microseconds");
+    writer.Uint64(latency_histogram.percentile(99));
+    writer.Key("max_microseconds");
+    writer.Uint64(latency_histogram.max());
+    writer.EndObject();
+  }
+
+  inline auto write_communication_statistics(const communication_statistics& communication_statistics, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartObject();
+    writer.Key("commands");
+    writer.StartObject();
+    for (const auto& [command, latency_histogram]: communication_statistics.latency_histograms()) {
+      writer.Key(command.c_str());
+      write_latency_histogram(latency_histogram, writer);
+    }
+    writer.EndObject();
+    writer.Key("sent_byte_count");
+    writer.Uint64(communication_statistics.sent_byte_count());
+    writer.Key("received_byte_count");
+    writer.Uint64(communication_statistics.received_byte_count());
+    writer.Key("timeout_count");
+    writer.Int(communication_statistics.timeout_count());
+    writer.Key("communication_error_count");
+    writer.Int(communication_statistics.communication_error_count());
+    writer.EndObject();
+  }
+
+  inline auto write_program_communication_statistics(const std::vector<std::tuple<std::string, communication_statistics>>& program_communication_statistics, rapidjson::Writer<rapidjson::StringBuffer>& writer) noexcept {
+    writer.StartArray();
+    for (const auto& [program_path, communication_statistics]: program_communication_statistics) {
+      writer.StartObject();
+      writer.Key("path");
+      writer.String(program_path.c_str());
+      writer.Key("statistics");
+      write_communication_statistics(communication_statistics, writer);
+      writer.EndObject();
+    }
+    writer.EndArray();
+  }
+}
@@ -0,0 +1,158 @@
+﻿#pragma once
+
+// Chrome（chrome://tracing）やPerfettoで表示できるtrace eventのJSONを出力するためのトレース。makeの際にTRACE=1を指定した場合（LIARS_DICE_TRACEが定義されている場合）だけ有効になります。
+// 無効な場合はマクロが空になるので、オーバーヘッドはありません。
+
+#ifdef LIARS_DICE_TRACE
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <rapidjson/writer.h>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+namespace liars_dice {
+  class tracer final {
+    struct event final {
+      std::string name;
+      int track_id;
+      std::int64_t starting_microseconds;
+      std::int64_t duration_microseconds;
+    };
+
+    std::chrono::steady_clock::time_point _starting_time;
+    std::vector<event> _events;
+    std::vector<std::string> _track_names;
+    std::unordered_map<std::string, int> _track_ids;
+    std::unordered_map<std::thread::id, int> _worker_numbers;
+    std::mutex _mutex;
+
+    tracer() noexcept: _starting_time(std::chrono::steady_clock::now()) {
+      ;
+    }
+
+    auto track_id(const std::string& track_name) {  // _mutexをロックしてから呼び出してください。
+      const auto& it = _track_ids.find(track_name);
+      if (it != std::end(_track_ids)) {
+        return it->second;
+      }
+
+      _track_names.emplace_back(track_name);
+
+      return _track_ids[track_name] = static_cast<int>(std::size(_track_names));
+    }
+
+  public:
+    static auto& instance() noexcept {
+      static auto result = tracer();
+
+      return result;
+    }
+
+    auto now() const noexcept {
+      return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _starting_time).count();
+    }
+
+    // 呼び出したスレッドのトラック名。スレッド毎に「worker n」という名前のトラックになります。
+    auto worker_track_name() {
+      const auto& lock = std::lock_guard(_mutex);
+
+      const auto& [it, _] = _worker_numbers.emplace(std::this_thread::get_id(), static_cast<int>(std::size(_worker_numbers)));
+
+      return "worker " + std::to_string(it->second);
+    }
+
+    auto add_event(const std::string& name, const std::string& track_name, std::int64_t starting_microseconds, std::int64_t duration_microseconds) {
+      const auto& lock = std::lock_guard(_mutex);
+
+      _events.emplace_back(event{name, track_id(track_name), starting_microseconds, duration_microseconds});
+    }
+
+    auto write(const std::string& path_string) {
+      const auto& lock = std::lock_guard(_mutex);
+
+      auto string_buffer = rapidjson::StringBuffer();
+      auto writer = rapidjson::Writer<rapidjson::StringBuffer>(string_buffer);
+
+      writer.StartObject();
+      writer.Key("traceEvents");
+      writer.StartArray();
+      for (auto i = 0; i < static_cast<int>(std::size(_track_names)); ++i) {
+        writer.StartObject();
+        writer.Key("name"); writer.String("thread_name");
+        writer.Key("ph"); writer.String("M");
+        writer.Key("pid"); writer.Int(1);
+        writer.Key("tid"); writer.Int(i + 1);
+        writer.Key("args");
+        writer.StartObject();
+        writer.Key("name"); writer.String(_track_names[i].c_str());
+        writer.EndObject();
+        writer.EndObject();
+      }
+      for (const auto& event: _events) {
+        writer.StartObject();
+        writer.Key("name"); writer.String(event.name.c_str());
+        writer.Key("ph"); writer.String("X");
+        writer.Key("pid"); writer.Int(1);
+        writer.Key("tid"); writer.Int(event.track_id);
+        writer.Key("ts"); writer.Int64(event.starting_microseconds);
+        writer.Key("dur"); writer.Int64(event.duration_microseconds);
+        writer.EndObject();
+      }
+      writer.EndArray();
+      writer.Key("displayTimeUnit"); writer.String("ms");
+      writer.EndObject();
+
+      auto ofstream = std::ofstream(path_string);
+      ofstream << string_buffer.GetString();
+      ofstream.close();
+    }
+  };
+
+  // スコープの開始から終了までを、ひとつのイベントとして記録します。
+  class trace_scope final {
+    std::string _name;
+    std::string _track_name;
+    std::int64_t _starting_microseconds;
+
+  public:
+    trace_scope(const std::string& name, const std::string& track_name): _name(name), _track_name(track_name), _starting_microseconds(tracer::instance().now()) {
+      ;
+    }
+
+    trace_scope(const std::string& name): trace_scope(name, tracer::instance().worker_track_name()) {
+      ;
+    }
+
+    trace_scope(const trace_scope&) = delete;
+    trace_scope& operator=(const trace_scope&) = delete;
+
+    ~trace_scope() {
+      tracer::instance().add_event(_name, _track_name, _starting_microseconds, tracer::instance().now() - _starting_microseconds);
+    }
+  };
+}
+
+#define LIARS_DICE_TRACE_CONCAT_(x, y) x##y
+#define LIARS_DICE_TRACE_CONCAT(x, y) LIARS_DICE_TRACE_CONCAT_(x, y)
+
+#define LIARS_DICE_TRACE_SCOPE(...) liars_dice::trace_scope LIARS_DICE_TRACE_CONCAT(trace_scope_, __LINE__)(__VA_ARGS__)
+#define LIARS_DICE_TRACE_WRITE(path_string) liars_dice::tracer::instance().write(path_string)
+
+#else
+
+#define LIARS_DICE_TRACE_SCOPE(...) ((void)0)
+#define LIARS_DICE_TRACE_WRITE(path_string) ((void)0)
+
+#endif
@@ -0,0 +1,133 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+
+namespace liars_dice {
+  // 置換表の値。MCTSなら訪問回数と報酬の合計、CFRなら反復回数と後悔の値のように、回数と値の組を想定しています。
+  struct transposition_entry final {
+    std::uint32_t count;
+    float value;
+  };
+
+  // 置換表。game::hash()をキーに、複数のスレッドからロックなしで読み書きできます。メモリはコンストラクタで指定した量から増えません。
+  // エントリーは(キー ^ 値, 値)の2つの64ビットのアトミック変数で、書き込みが混ざって壊れたエントリーは、キーが一致しなくなるので読み捨てられます。
+  // キーはハッシュの最上位ビットを1にしたもので、0で初期化された空のエントリーは、値が{0, 0.0f}でもどのキーとも一致しません。
+  // 4エントリー（64バイト）のバケットをキャッシュ・ラインに揃えて確保して、同じキーがなければ、空いているエントリーか、countが最も小さいエントリーを置き換えます。
+  class transposition_table final {
+    struct entry final {
+      std::atomic<std::uint64_t> check;
+      std::atomic<std::uint64_t> data;
+    };
+
+    static constexpr auto bucket_size = 4;
+
+    struct alignas(64) bucket final {
+      entry entries[bucket_size];
+    };
+
+    static_assert(sizeof(bucket) == 64);
+
+    static constexpr auto occupied_tag = static_cast<std::uint64_t>(1) << 63;
+
+    std::unique_ptr<bucket[]> _buckets;
+    std::uint64_t _bucket_mask;
+
+    static auto key(std::uint64_t hash) noexcept {
+      return hash | occupied_tag;
+    }
+
+    static auto pack(const transposition_entry& transposition_entry) noexcept {
+      auto result = static_cast<std::uint64_t>(0);
+
+      std::memcpy(&result, &transposition_entry, sizeof(transposition_entry));
+
+      return result;
+    }
+
+    static auto unpack(std::uint64_t data) noexcept {
+      auto result = transposition_entry();
+
+      std::memcpy(&result, &data, sizeof(result));
+
+      return result;
+    }
+
+    static auto bucket_count(std::size_t byte_count) noexcept {
+      auto result = static_cast<std::uint64_t>(1);
+
+      while (result * 2 * sizeof(bucket) <= byte_count) {
+        result *= 2;
+      }
+
+      return result;
+    }
+
+  public:
+    // byte_count以下で最大の、2のべき乗個のバケットを確保します。エントリーは0（空）で初期化されます。
+    transposition_table(std::size_t byte_count): _buckets(new bucket[bucket_count(byte_count)]()), _bucket_mask(bucket_count(byte_count) - 1) {
+      ;
+    }
+
+    auto size() const noexcept {
+      return static_cast<std::size_t>((_bucket_mask + 1) * bucket_size);
+    }
+
+    // 他のスレッドが読み書きしていない時に呼んでください。
+    auto clear() noexcept {
+      for (auto i = static_cast<std::size_t>(0); i <= _bucket_mask; ++i) {
+        for (auto& entry: _buckets[i].entries) {
+          entry.check.store(0, std::memory_order_relaxed);
+          entry.data.store(0, std::memory_order_relaxed);
+        }
+      }
+    }
+
+    auto find(std::uint64_t hash) const noexcept -> std::optional<transposition_entry> {
+      const auto& entries = _buckets[hash & _bucket_mask].entries;
+
+      for (auto i = 0; i < bucket_size; ++i) {
+        const auto& data = entries[i].data.load(std::memory_order_relaxed);
+
+        if ((entries[i].check.load(std::memory_order_relaxed) ^ data) == key(hash)) {
+          return unpack(data);
+        }
+      }
+
+      return std::nullopt;
+    }
+
+    auto store(std::uint64_t hash, const transposition_entry& transposition_entry) noexcept {
+      auto& entries = _buckets[hash & _bucket_mask].entries;
+
+      auto replaced_index = 0;
+      auto replaced_count = std::numeric_limits<std::uint32_t>::max();
+
+      for (auto i = 0; i < bucket_size; ++i) {
+        const auto& data       = entries[i].data.load(std::memory_order_relaxed);
+        const auto& stored_key = entries[i].check.load(std::memory_order_relaxed) ^ data;
+
+        // 同じキーか、空いている（キーの最上位ビットが0の）エントリーなら、そこに書きます。
+        if (stored_key == key(hash) || !(stored_key & occupied_tag)) {
+          replaced_index = i;
+
+          break;
+        }
+
+        if (unpack(data).count < replaced_count) {
+          replaced_index = i;
+          replaced_count = unpack(data).count;
+        }
+      }
+
+      const auto& data = pack(transposition_entry);
+
+      entries[replaced_index].check.store(key(hash) ^ data, std::memory_order_relaxed);
+      entries[replaced_index].data.store(data, std::memory_order_relaxed);
+    }
+  };
+}
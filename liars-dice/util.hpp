@@ -1,6 +1,13 @@
 ﻿#pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <thread>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #ifdef _MSC_VER
 #pragma warning(push, 0)
@@ -28,4 +35,72 @@ namespace util {
   auto combine(Ranges&&... ranges) noexcept {
     return boost::combine(ranges...) | boost::adaptors::transformed([](const auto& combined) { return as_std_tuple(combined); });
   }
+
+  // 種と番号から、別の種を作成します（SplitMix64）。セット毎やゲーム毎の乱数を、実行順序に関係なく再現できるようにするためのものです。
+  inline auto mix_seed(std::uint64_t seed, std::uint64_t stream) noexcept {
+    auto result = seed + (stream + 1) * 0x9e3779b97f4a7c15;
+
+    result = (result ^ (result >> 30)) * 0xbf58476d1ce4e5b9;
+    result = (result ^ (result >> 27)) * 0x94d049bb133111eb;
+
+    return result ^ (result >> 31);
+  }
+
+  // mix_seedを使った乱数。std::uniform_int_distributionやstd::shuffleは結果が標準ライブラリの実装に依存して、同じ種でもlibstdc++とMSVCで違う結果になってしまうので、
+  // 種から結果が決まらなければならない場所（ダイスの目や席順）では、こちらを使用します。
+  class portable_random_engine final {
+    std::uint64_t _seed;
+    std::uint64_t _index;
+
+  public:
+    portable_random_engine(std::uint64_t seed) noexcept: _seed(seed), _index(0) {
+      ;
+    }
+
+    auto operator()() noexcept {
+      return mix_seed(_seed, _index++);
+    }
+
+    // 0からcount - 1までの一様な整数。剰余の偏りが出ないように、2^64をcountで割った余りより小さい値は捨てます。
+    auto uniform(std::uint64_t count) noexcept {
+      const auto& threshold = (0 - count) % count;
+
+      for (;;) {
+        const auto& value = (*this)();
+
+        if (value >= threshold) {
+          return value % count;
+        }
+      }
+    }
+  };
+
+  // Fisher-Yatesのシャッフル。
+  template <typename Range>
+  inline auto shuffle(Range& range, portable_random_engine& random_engine) noexcept {
+    for (auto i = std::size(range); i > 1; --i) {
+      std::swap(range[i - 1], range[random_engine.uniform(i)]);
+    }
+  }
+
+  // 0からcount - 1までの番号でfunctionを呼び出す処理を、CPUのコア数のスレッドで分担して実行します。functionは、どの順番で呼ばれても良いようにしてください。
+  template <typename Function>
+  inline auto parallel_for(int count, Function&& function) {
+    auto next_index = std::atomic<int>(0);
+
+    auto threads = std::vector<std::thread>();
+
+    for (auto i = 0; i < std::min(count, static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u))); ++i) {
+      threads.emplace_back(
+        [&]() {
+          for (auto index = next_index++; index < count; index = next_index++) {
+            function(index);
+          }
+        });
+    }
+
+    for (auto& thread: threads) {
+      thread.join();
+    }
+  }
 }
@@ -0,0 +1,11 @@
+﻿#include <chrono>
+#include <string>
+
+#include "mcts.hpp"
+
+// 引数で、1手あたりの思考時間（ミリ秒）を指定できます。プロセス間の通信の時間があるので、500ミリ秒の制限より短めにしています。
+int main(int argc, char** argv) {
+  mcts(std::chrono::milliseconds(argc > 1 ? std::stoi(argv[1]) : 400)).execute();
+
+  return 0;
+}
@@ -0,0 +1,312 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)
+#endif
+#include <boost/range/adaptors.hpp>
+#include <boost/range/irange.hpp>
+#include <boost/range/numeric.hpp>
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "../liars-dice/program.hpp"
+
+// 情報集合モンテカルロ木探索（SO-ISMCTS）で手を選ぶプログラム。
+// 他のプレイヤーのダイスの目は見えないので、木を辿る度にランダムに決めます。だから、木のノードは公開されている手の並びに対応します。
+// CPUのコア数のスレッドがそれぞれ独立した木を作って（root parallelism）、時間切れになったらルートの子の訪問回数を合計して手を決めます。
+
+class mcts: public liars_dice::program {
+  struct node final {
+    liars_dice::action action;  // このノードに至った手。
+    int player_index;           // その手を打ったプレイヤー。
+    int visit_count;
+    float total_reward;
+    int first_child_index;
+    int child_count;
+  };
+
+  static constexpr auto max_node_count  = 1 << 20;  // スレッド毎のノード数の上限。これを超えたら、木を広げずにプレイアウトだけします。
+  static constexpr auto exploration     = 0.7f;
+  static constexpr auto bid_count_width = 3;        // 宣言できる最小の個数から、いくつまでを候補にするか。
+
+  std::mt19937_64 _random_engine;
+  std::chrono::milliseconds _time_limit;
+  std::vector<std::vector<node>> _node_arenas;  // [スレッド]。手番毎に確保し直さないように、clear()して使い回します。
+
+  // 目をfaceにする場合に、宣言できる最小の個数。
+  static auto min_bid_count(const liars_dice::game& game, int face) noexcept {
+    const auto& previous_actions = game.players()[game.previous_player_index()].actions();
+
+    if (std::empty(previous_actions)) {
+      return 1;
+    }
+
+    const auto& previous_bid = previous_actions.back().bid().value();
+
+    return face > previous_bid.face() ? previous_bid.min_count() : previous_bid.min_count() + 1;
+  }
+
+  static auto dice_count(const liars_dice::game& game) noexcept {
+    return boost::accumulate(game.players() | boost::adaptors::transformed([](const auto& player) { return static_cast<int>(std::size(player.faces())); }), 0);
+  }
+
+  // 木で考慮する手。全ての宣言を考慮すると枝が多すぎるので、目毎に最小の個数から3個までと、チャレンジに絞ります。
+  static auto candidate_actions(const liars_dice::game& game) noexcept {
+    auto result = std::vector<liars_dice::action>();
+
+    if (game.is_legal_action(liars_dice::challenge())) {
+      result.emplace_back(liars_dice::challenge());
+    }
+
+    const auto& max_count = static_cast<int>(std::min(game.max_bid_count(), dice_count(game)));
+
+    for (auto face = 2; face <= 6; ++face) {
+      for (auto count = min_bid_count(game, face); count < min_bid_count(game, face) + bid_count_width && count <= max_count; ++count) {
+        result.emplace_back(liars_dice::bid(face, count));
+      }
+    }
+
+    // 全員のダイスより多い数しか宣言できない場合でも、チャレンジできない最初の手番では何か宣言しなければなりません。
+    if (std::empty(result)) {
+      result.emplace_back(liars_dice::bid(6, min_bid_count(game, 6)));
+    }
+
+    return result;
+  }
+
+  // 見えていないダイスの目を、ランダムに決めます。
+  static auto determinize(const liars_dice::game& game, std::mt19937_64& random_engine) noexcept {
+    auto players = game.players();
+
+    for (auto i = 0; i < static_cast<int>(std::size(players)); ++i) {
+      if (i == game.player_index()) {
+        continue;
+      }
+
+      for (auto& face: players[i].faces()) {
+        face = std::uniform_int_distribution(1, 6)(random_engine);
+      }
+    }
+
+    return liars_dice::game(players, game.player_index(), game.max_bid_count());
+  }
+
+  // プレイアウト。各プレイヤーは、自分のダイスと、見えないダイスの1/3がその目だという見込みだけで判断します（hardheadに近い戦略です）。
+  static auto playout(liars_dice::game& game, std::mt19937_64& random_engine) noexcept {
+    const auto& total_dice_count = dice_count(game);
+
+    const auto& estimated_face_counts = boost::copy_range<std::vector<std::array<float, 7>>>(
+      game.players() |
+      boost::adaptors::transformed(
+        [&](const auto& player) {
+          auto result = std::array<float, 7>{};
+
+          for (auto face = 2; face <= 6; ++face) {
+            result[face] = static_cast<float>(std::count_if(std::begin(player.faces()), std::end(player.faces()), [&](const auto& player_face) { return player_face == 1 || player_face == face; })) + (total_dice_count - static_cast<int>(std::size(player.faces()))) / 3.0f;
+          }
+
+          return result;
+        }));
+
+    auto bids = std::vector<liars_dice::bid>(); bids.reserve(5);
+
+    while (!game.is_end()) {
+      const auto& estimated_face_counts_ = estimated_face_counts[game.player_index()];
+      const auto& previous_actions       = game.players()[game.previous_player_index()].actions();
+
+      if (!std::empty(previous_actions)) {
+        const auto& previous_bid = previous_actions.back().bid().value();
+
+        if (previous_bid.min_count() > estimated_face_counts_[previous_bid.face()] + std::uniform_real_distribution(-1.0f, 1.0f)(random_engine)) {
+          game.do_action(liars_dice::challenge());
+
+          continue;
+        }
+      }
+
+      bids.clear();
+
+      for (auto face = 2; face <= 6; ++face) {
+        const auto& count = min_bid_count(game, face);
+
+        if (count <= game.max_bid_count() && count <= estimated_face_counts_[face]) {
+          bids.emplace_back(face, count);
+        }
+      }
+
+      if (std::empty(bids)) {
+        game.do_action(std::empty(previous_actions) ? liars_dice::action(liars_dice::bid(6, 1)) : liars_dice::action(liars_dice::challenge()));
+
+        continue;
+      }
+
+      game.do_action(bids[std::uniform_int_distribution(0, static_cast<int>(std::size(bids)) - 1)(random_engine)]);
+    }
+  }
+
+  // 報酬は、残ったダイスの割合です。ダイスを失わなければ1、全て失えば0になります。
+  static auto rewards(const liars_dice::game& game) noexcept {
+    const auto& dice_count_deltas = game.dice_count_deltas();
+
+    return boost::copy_range<std::vector<float>>(
+      boost::irange(0, static_cast<int>(std::size(game.players()))) |
+      boost::adaptors::transformed(
+        [&](const auto& i) {
+          const auto& dice_count = static_cast<int>(std::size(game.players()[i].faces()));
+
+          return dice_count == 0 ? 1.0f : 1.0f + static_cast<float>(std::max(dice_count_deltas[i], -dice_count)) / dice_count;
+        }));
+  }
+
+  // 1スレッド分の探索。木はnodesに作ります。ルートの子の訪問回数と、プレイアウトの回数を返します。
+  static auto search(const liars_dice::game& root_game, const std::vector<liars_dice::action>& root_actions, const std::chrono::steady_clock::time_point& deadline, std::uint64_t seed, std::vector<node>& nodes) noexcept {
+    auto random_engine = std::mt19937_64(seed);
+
+    nodes.clear();
+
+    nodes.push_back(node{liars_dice::action(liars_dice::challenge()), root_game.previous_player_index(), 0, 0, 1, static_cast<int>(std::size(root_actions))});
+
+    for (const auto& action: root_actions) {
+      nodes.push_back(node{action, root_game.player_index(), 0, 0, 0, 0});
+    }
+
+    auto path = std::vector<int>(); path.reserve(64);
+    auto playout_count = 0;
+
+    for (; std::chrono::steady_clock::now() < deadline; ++playout_count) {
+      auto game = determinize(root_game, random_engine);
+
+      path.clear();
+      path.emplace_back(0);
+
+      // 選択と展開。
+      while (!game.is_end()) {
+        const auto& node_index = path.back();
+
+        if (nodes[node_index].child_count == 0) {
+          if (nodes[node_index].visit_count == 0 || std::size(nodes) + 1 + 5 * bid_count_width > max_node_count) {
+            break;
+          }
+
+          const auto& actions = candidate_actions(game);
+
+          nodes[node_index].first_child_index = static_cast<int>(std::size(nodes));
+          nodes[node_index].child_count       = static_cast<int>(std::size(actions));
+
+          for (const auto& action: actions) {
+            nodes.push_back(node{action, game.player_index(), 0, 0, 0, 0});
+          }
+        }
+
+        const auto& parent = nodes[node_index];
+
+        const auto& child_index = [&]() {
+          const auto& log_visit_count = std::log(static_cast<float>(parent.visit_count + 1));
+
+          auto result     = -1;
+          auto best_value = -std::numeric_limits<float>::infinity();
+
+          for (auto i = parent.first_child_index; i < parent.first_child_index + parent.child_count; ++i) {
+            if (nodes[i].visit_count == 0) {
+              return i;
+            }
+
+            const auto& value = nodes[i].total_reward / nodes[i].visit_count + exploration * std::sqrt(log_visit_count / nodes[i].visit_count);
+
+            if (value > best_value) {
+              result     = i;
+              best_value = value;
+            }
+          }
+
+          return result;
+        }();
+
+        game.do_action(nodes[child_index].action);
+        path.emplace_back(child_index);
+      }
+
+      // シミュレーション。
+      playout(game, random_engine);
+
+      // 逆伝播。
+      const auto& rewards_ = rewards(game);
+
+      for (const auto& node_index: path) {
+        nodes[node_index].visit_count++;
+        nodes[node_index].total_reward += rewards_[nodes[node_index].player_index];
+      }
+    }
+
+    return std::make_tuple(
+      boost::copy_range<std::vector<int>>(boost::irange(1, 1 + static_cast<int>(std::size(root_actions))) | boost::adaptors::transformed([&](const auto& i) { return nodes[i].visit_count; })),
+      playout_count);
+  }
+
+public:
+  mcts(const std::chrono::milliseconds& time_limit) noexcept: _random_engine(std::random_device()()), _time_limit(time_limit), _node_arenas(std::max(std::thread::hardware_concurrency(), 1u)) {
+    ;
+  }
+
+  void check_other_programs(const std::vector<liars_dice::career>& careers) noexcept {
+    ;
+  }
+
+  liars_dice::action action(const liars_dice::game& game) noexcept {
+    const auto& starting_time = std::chrono::steady_clock::now();
+    const auto& deadline      = starting_time + _time_limit;
+
+    const auto& root_actions = candidate_actions(game);
+
+    if (std::size(root_actions) == 1) {
+      return root_actions.front();
+    }
+
+    const auto& thread_count = static_cast<int>(std::size(_node_arenas));
+
+    auto results = std::vector<std::tuple<std::vector<int>, int>>(thread_count);
+    auto threads = std::vector<std::thread>();
+
+    for (auto i = 0; i < thread_count; ++i) {
+      threads.emplace_back([&, i, seed = _random_engine()]() { results[i] = search(game, root_actions, deadline, seed, _node_arenas[i]); });
+    }
+
+    for (auto& thread: threads) {
+      thread.join();
+    }
+
+    auto visit_counts  = std::vector<int>(std::size(root_actions), 0);
+    auto playout_count = 0;
+
+    for (const auto& [visit_counts_, playout_count_]: results) {
+      for (auto i = 0; i < static_cast<int>(std::size(visit_counts)); ++i) {
+        visit_counts[i] += visit_counts_[i];
+      }
+
+      playout_count += playout_count_;
+    }
+
+    const auto& seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - starting_time).count();
+
+    std::cerr << playout_count << " playouts\t" << thread_count << " threads\t" << static_cast<int>(playout_count / seconds) << " playouts/sec" << std::endl;
+
+    return root_actions[std::max_element(std::begin(visit_counts), std::end(visit_counts)) - std::begin(visit_counts)];
+  }
+
+  void game_end(const liars_dice::game& game) noexcept {
+    ;
+  }
+};